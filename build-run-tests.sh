@@ -28,8 +28,10 @@ do_build Debug "-Og"
 EXITCODE=0
 
 "${BUILD_DIR}"/pgn-reader/hoover-pgn-reader-tests || EXITCODE=$?
+"${BUILD_DIR}"/utils/hoover-utils-tests || EXITCODE=$?
 echo
 echo "To invoke individual tests:"
 echo "    ${BUILD_DIR}/pgn-reader/hoover-pgn-reader-tests --gtest_filter=<test-name>"
+echo "    ${BUILD_DIR}/utils/hoover-utils-tests --gtest_filter=<test-name>"
 
 exit $EXITCODE
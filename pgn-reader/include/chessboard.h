@@ -77,6 +77,27 @@ struct BitBoard
     SquareSet whitePieces;
 };
 
+/// @ingroup PgnReaderAPI
+/// @brief Board state that is not recoverable from a move alone. Used for
+/// undoing a move.
+///
+/// @sa @coderef{ChessBoard::doMove(Move, MoveUndoInfo &)}, @coderef{ChessBoard::undoMove()}
+struct MoveUndoInfo
+{
+    /// @brief Captured piece or @coderef{Piece::NONE}. The pawn captured by
+    /// an en-passant move is implied by the move and not recorded here.
+    Piece capturedPiece;
+
+    /// @brief En-passant square before the move
+    Square epSquare;
+
+    /// @brief Half move clock before the move
+    std::uint8_t halfMoveClock;
+
+    /// @brief Castling rooks before the move
+    std::array<Square, 4U> castlingRooks;
+};
+
 /// @brief Underlying type of @coderef{MoveTypeAndPromotion}
 using MoveTypeAndPromotionUnderlyingType = std::uint_fast8_t;
 
@@ -1310,6 +1331,19 @@ public:
     /// @return           Legal moves available.
     inline bool hasLegalMoves() const noexcept;
 
+    /// @brief Determines whether a move checks the opponent king. The move is
+    /// assumed to be legal, and it must be from one of the generators.
+    ///
+    /// @param[in] m    Move
+    /// @return         Whether the position after the move is a check
+    ///
+    /// This function is a cheaper alternative to applying the move with
+    /// @coderef{doMove()} and querying @coderef{isInCheck()}. Direct checks
+    /// are resolved by the attack pattern of the moved piece on its
+    /// destination, and discovered checks by the lines from the opponent
+    /// king through the vacated squares.
+    bool givesCheck(Move m) const noexcept;
+
     /// @brief Applies a move on the current position. The move is assumed to be
     /// legal, and it must be from one of the generators. No legality checks are
     /// done by this function.
@@ -1326,6 +1360,25 @@ public:
     /// - Recalculates checkers @fullonly{(@coderef{m_checkers})}@apionly{(see @coderef{getCheckers()})}
     void doMove(Move m) noexcept;
 
+    /// @brief Applies a move on the current position and records the
+    /// information needed to undo it. Otherwise, this is the same as
+    /// @coderef{doMove(Move)}.
+    ///
+    /// @param[in]  m          Move to apply
+    /// @param[out] undoInfo   Information for @coderef{undoMove()}
+    void doMove(Move m, MoveUndoInfo &undoInfo) noexcept;
+
+    /// @brief Reverts a move applied by @coderef{doMove(Move, MoveUndoInfo &)}.
+    /// The move must be the last move applied on the board.
+    ///
+    /// @param[in] m          Move to revert
+    /// @param[in] undoInfo   Undo information recorded when the move was applied
+    ///
+    /// Undoing a move is cheaper than saving and restoring the whole board
+    /// when only a few moves need to be reverted. Checkers and pinned pieces
+    /// are recalculated.
+    void undoMove(Move m, const MoveUndoInfo &undoInfo) noexcept;
+
     /// @brief Comparison operator (equality)
     ///
     /// @param[in]  o    Another chessboard
@@ -17,6 +17,10 @@
 #ifndef HOOVER_CHESS_UTILS__PGN_READER__PGNREADER_ERROR_H_INCLUDED
 #define HOOVER_CHESS_UTILS__PGN_READER__PGNREADER_ERROR_H_INCLUDED
 
+#include "chessboard-types.h"
+#include "chessboard-types-squareset.h"
+
+#include <cstdint>
 #include <exception>
 #include <string>
 #include <string_view>
@@ -65,16 +69,91 @@ enum class PgnErrorCode : unsigned
     INTERNAL_ERROR,
 };
 
+/// @brief Details of a move that failed validation
+///
+/// @sa @coderef{PgnError::getMoveInfo()}
+struct PgnErrorMoveInfo
+{
+    /// @brief Ply number of the move
+    std::uint32_t plyNum;
+
+    /// @brief Moving piece. For castling moves, this is @coderef{Piece::KING}.
+    Piece piece;
+
+    /// @brief Allowed source squares as specified by the move. For castling
+    /// moves, this is an empty set.
+    SquareSet srcMask;
+
+    /// @brief Destination square. For castling moves, this is
+    /// @coderef{Square::NONE}.
+    Square dst;
+
+    /// @brief Promotion piece or @coderef{Piece::NONE}
+    Piece promo;
+
+    /// @brief Whether the move was specified as a capture
+    bool capture;
+
+    /// @brief Whether the move is a short castling move. Meaningful only for
+    /// castling moves.
+    bool shortCastle;
+};
+
 /// @brief PGN error exception
+///
+/// The error message is formatted lazily on the first call to
+/// @coderef{what()}. This keeps the cost of raising an error low in case the
+/// caller is interested only in the error code and the structured error
+/// details.
 class PgnError : public std::exception
 {
 private:
-    /// @brief Error string
-    std::string m_str;
+    /// @brief Type of the error details
+    enum class DetailsType : std::uint8_t
+    {
+        /// @brief Free-form text
+        TEXT,
+
+        /// @brief Move validation error
+        MOVE,
+
+        /// @brief Unexpected move number
+        MOVE_NUM,
+    };
+
+    /// @brief Formatted error message. Empty until formatted by
+    /// @coderef{what()}.
+    mutable std::string m_str { };
+
+    /// @brief Free-form error details
+    std::string m_details { };
+
+    /// @brief Line number of the error, or 0 if unknown
+    std::uint64_t m_lineNumber { };
+
+    /// @brief Input byte offset of the error
+    std::uint64_t m_byteOffset { };
+
+    /// @brief Move validation error details
+    PgnErrorMoveInfo m_moveInfo { };
+
+    /// @brief Expected move number
+    std::uint32_t m_expectedMoveNum { };
+
+    /// @brief Actual move number
+    std::uint32_t m_actualMoveNum { };
 
     /// @brief Error code
     PgnErrorCode m_code;
 
+    /// @brief Type of the error details
+    DetailsType m_detailsType;
+
+    /// @brief Formats the error message
+    ///
+    /// @return Error message
+    std::string formatMessage() const;
+
 public:
     /// @brief Constructor: error code and error message
     ///
@@ -82,6 +161,18 @@ public:
     /// @param[in]  details      Error message (additional details)
     PgnError(PgnErrorCode code, std::string_view details);
 
+    /// @brief Constructor: move validation error
+    ///
+    /// @param[in]  code         Error code
+    /// @param[in]  moveInfo     Details of the move
+    PgnError(PgnErrorCode code, const PgnErrorMoveInfo &moveInfo) noexcept;
+
+    /// @brief Constructor: unexpected move number
+    ///
+    /// @param[in]  expectedMoveNum   Expected move number
+    /// @param[in]  actualMoveNum     Move number in the input
+    PgnError(std::uint32_t expectedMoveNum, std::uint32_t actualMoveNum) noexcept;
+
     /// @brief Constructor: adds position to a PGN error
     ///
     /// @param[in]  scanner      Tokenizer for error location
@@ -91,10 +182,10 @@ public:
     /// @brief Returns the error message
     ///
     /// @return Error message
-    const char *what() const noexcept override
-    {
-        return m_str.c_str();
-    }
+    ///
+    /// The message is formatted on the first call. The first call should not
+    /// be made concurrently from multiple threads.
+    const char *what() const noexcept override;
 
     /// @brief Returns the error code
     ///
@@ -104,12 +195,48 @@ public:
         return m_code;
     }
 
+    /// @brief Returns the move validation error details
+    ///
+    /// @return Move details, or @c nullptr if the error is not a move
+    ///         validation error
+    const PgnErrorMoveInfo *getMoveInfo() const noexcept
+    {
+        return m_detailsType == DetailsType::MOVE ? &m_moveInfo : nullptr;
+    }
+
+    /// @brief Returns the line number of the error
+    ///
+    /// @return Line number, or 0 if unknown. Numbering starts from 1.
+    std::uint64_t getLineNumber() const noexcept
+    {
+        return m_lineNumber;
+    }
+
+    /// @brief Returns the input byte offset of the error
+    ///
+    /// @return Byte offset of the token at which the error was detected. Valid
+    ///         only when @coderef{getLineNumber()} is non-zero.
+    std::uint64_t getByteOffset() const noexcept
+    {
+        return m_byteOffset;
+    }
+
+    /// @brief Sets the error location
+    ///
+    /// @param[in]  lineNumber   Line number. Numbering starts from 1.
+    /// @param[in]  byteOffset   Input byte offset
+    void setLocation(std::uint64_t lineNumber, std::uint64_t byteOffset) noexcept
+    {
+        m_lineNumber = lineNumber;
+        m_byteOffset = byteOffset;
+        m_str.clear();
+    }
+
     /// @brief Returns error string for code
     ///
     /// @param[in]  code         Error code
     /// @return                  Error string
     static std::string_view getStringForCode(PgnErrorCode code) noexcept;
-
 };
 
 /// @}
@@ -625,18 +625,16 @@ public:
     /// @param[in] move     Move to play
     /// @throws PgnError(PgnErrorCode::ILLEGAL_MOVE)   Illegal move
     ///
-    /// This function is implemented using @coderef{moveToSanAndPlay()}. In case
+    /// The check indicator is determined with @coderef{ChessBoard::givesCheck()}
+    /// without playing the move. The move is played on a copy of the board
+    /// only for checks, in order to tell checks and checkmates apart. In case
     /// the intention is to produce SAN notation while replaying the moves, it
     /// is faster to invoke @coderef{moveToSanAndPlay()} to combine the
     /// activities than calling this function and @coderef{ChessBoard::doMove()}
     /// separately.
     ///
     /// @sa @coderef{moveToSanAndPlay()} for full specification.
-    static MiniString<7U> moveToSan(const ChessBoard &board, Move move)
-    {
-        ChessBoard tmpBoard { board };
-        return moveToSanAndPlay(tmpBoard, move);
-    }
+    static MiniString<7U> moveToSan(const ChessBoard &board, Move move);
 
     /// @brief Returns a name string for @coderef{PieceAndColor}.
     ///
@@ -671,6 +669,15 @@ public:
     /// @param[in]  fen           FEN for the position
     static void boardToFEN(const ChessBoard &board, FenString &fen) noexcept;
 
+private:
+    /// @brief Writes SAN for a move without the check/checkmate indicator.
+    ///
+    /// @param[in]  board   Chess board
+    /// @param[in]  move    Move
+    /// @param[out] out     Output buffer, at least 6 characters
+    /// @return             End of the written string
+    /// @throws PgnError(PgnErrorCode::ILLEGAL_MOVE)   Illegal move
+    static char *moveToSanBody(const ChessBoard &board, Move move, char *out);
 };
 
 /// @}
@@ -24,6 +24,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <format>
+#include <iterator>
+#include <memory>
+#include <span>
 #include <string_view>
 
 namespace hoover_chess_utils::pgn_reader
@@ -54,6 +57,134 @@ struct PgnErrorInfo
 {
     /// @brief Line number of the error. Numbering starts from 1.
     std::uint64_t lineNumber;
+
+    /// @brief Input byte offset of the token at which the error was detected
+    std::uint64_t byteOffset;
+};
+
+/// @brief Input location of the game being read
+///
+/// All offsets are byte offsets from the start of the PGN input. The game
+/// section boundaries are recorded as the game is parsed, and the token
+/// location is read from the scanner on demand. Hence, maintaining the location
+/// has practically no cost.
+///
+/// The sections of a game are:
+/// - Tag section: from @coderef{getGameOffset()}, length
+///   @coderef{getTagSectionLength()}. This includes any comments between the
+///   tags and the whitespace before the movetext.
+/// - Movetext: from @coderef{getMoveTextOffset()}, length
+///   @coderef{getMoveTextLength()}. This includes the game termination marker.
+///
+/// Section lengths are zero until the end of the section has been reached.
+///
+/// @sa @coderef{PgnReaderActions::setInputLocationReference()}
+class PgnInputLocation
+{
+private:
+    /// @brief Scanner for the token location
+    const PgnScanner &m_scanner;
+
+    /// @brief Offset of the first token of the game
+    std::uint64_t m_gameOffset { };
+
+    /// @brief Offset of the first token of the movetext
+    std::uint64_t m_moveTextOffset { };
+
+    /// @brief Offset just past the game termination marker
+    std::uint64_t m_gameEndOffset { };
+
+    /// @brief The PGN reader parser actions construct the location and record
+    /// the game section boundaries
+    template <typename, typename, typename>
+    friend class PgnReaderParserActions;
+
+    /// @brief Constructor
+    ///
+    /// @param[in]  scanner      Scanner for the token location
+    explicit PgnInputLocation(const PgnScanner &scanner) noexcept :
+        m_scanner { scanner }
+    {
+    }
+
+    /// @brief Records the start of a game at the current token
+    void recordGameStart() noexcept;
+
+    /// @brief Records the start of the movetext at the current token
+    void recordMoveTextStart() noexcept;
+
+    /// @brief Records the end of a game at the end of the current token
+    void recordGameEnd() noexcept;
+
+public:
+    /// @brief Copy constructor (deleted)
+    PgnInputLocation(const PgnInputLocation &) = delete;
+
+    /// @brief Move constructor (deleted)
+    PgnInputLocation(PgnInputLocation &&) = delete;
+
+    /// @brief Copy assignment (deleted)
+    PgnInputLocation &operator = (const PgnInputLocation &) & = delete;
+
+    /// @brief Move assignment (deleted)
+    PgnInputLocation &operator = (PgnInputLocation &&) & = delete;
+
+    /// @brief Returns the offset of the current game
+    ///
+    /// @return Offset of the first token of the game
+    std::uint64_t getGameOffset() const noexcept
+    {
+        return m_gameOffset;
+    }
+
+    /// @brief Returns the length of the current game
+    ///
+    /// @return Length of the game. Valid from @coderef{PgnReaderActions::gameTerminated()}.
+    std::uint64_t getGameLength() const noexcept
+    {
+        return m_gameEndOffset - m_gameOffset;
+    }
+
+    /// @brief Returns the length of the tag section of the current game
+    ///
+    /// @return Length of the tag section. Valid from @coderef{PgnReaderActions::moveTextSection()}.
+    std::uint64_t getTagSectionLength() const noexcept
+    {
+        return m_moveTextOffset - m_gameOffset;
+    }
+
+    /// @brief Returns the offset of the movetext of the current game
+    ///
+    /// @return Offset of the first token of the movetext. Valid from
+    ///         @coderef{PgnReaderActions::moveTextSection()}.
+    std::uint64_t getMoveTextOffset() const noexcept
+    {
+        return m_moveTextOffset;
+    }
+
+    /// @brief Returns the length of the movetext of the current game
+    ///
+    /// @return Length of the movetext. Valid from @coderef{PgnReaderActions::gameTerminated()}.
+    std::uint64_t getMoveTextLength() const noexcept
+    {
+        return m_gameEndOffset - m_moveTextOffset;
+    }
+
+    /// @brief Returns the offset of the current token
+    ///
+    /// @return Offset of the token
+    ///
+    /// In move callbacks, the current token is the move. In other callbacks,
+    /// the current token is the last token of the construct that triggered
+    /// the callback, or the token following it.
+    std::uint64_t getTokenOffset() const noexcept;
+
+    /// @brief Returns the length of the current token
+    ///
+    /// @return Length of the token
+    ///
+    /// @sa @coderef{getTokenOffset()}
+    std::uint64_t getTokenLength() const noexcept;
 };
 
 /// @brief Semantic actions for reading a PGN. The caller is expected to inherit
@@ -123,6 +254,18 @@ public:
         static_cast<void>(prevBoard);
     }
 
+    /// @brief Invoked when the PGN reader is instantiated.
+    ///
+    /// @param[in]  location       Input location, updated by the reader during
+    ///                            parsing
+    ///
+    /// The location is valid until the reader returns. Callback is always
+    /// enabled.
+    virtual void setInputLocationReference(const PgnInputLocation &location)
+    {
+        static_cast<void>(location);
+    }
+
     /// @brief Invoked after a move is processed.
     ///
     /// @param[in]  move     Move
@@ -185,6 +328,11 @@ public:
     /// correctness of the PGN input. When such an error occurs, this callback
     /// function is invoked, which then returns the policy action.
     ///
+    /// The error message is formatted only when @coderef{PgnError::what()} is
+    /// called. Handlers that only count or classify errors should prefer
+    /// @coderef{PgnError::getCode()}, @coderef{PgnError::getMoveInfo()}, and
+    /// @p additionalInfo, which are available without formatting.
+    ///
     /// The actions are:
     /// - @coderef{PgnReaderOnErrorAction::Abort} (default) --- Abort processing and
     ///   re-throw the PGN error exception as is. This is the default policy in
@@ -201,10 +349,13 @@ public:
     ///
     /// Internally, the procedure to skip to the next game when
     /// @coderef{PgnReaderOnErrorAction::ContinueFromNextGame} is returned is
-    /// straightforward. The tokenizer is invoked until it returns either RESULT
-    /// (i.e., @c "1-0", @c "1/2-1/2", @c "0-1", @c "*") or END_OF_FILE
-    /// tokens. It is possible that more than more error is returned for a
-    /// single erroneous game.
+    /// straightforward. The input is searched for the next line that begins
+    /// with @c '[' and that is not preceded by another line beginning with
+    /// @c '['. That is, the rest of the erroneous game is skipped, including
+    /// the remaining tag pairs if the error was in the tag pair section. The
+    /// skipped input is not tokenized. Parsing continues from the found line,
+    /// or ends if there is none. Note that games without tag pairs following
+    /// an erroneous game are skipped, too.
     virtual PgnReaderOnErrorAction onError(const PgnError &error, const PgnErrorInfo &additionalInfo)
     {
         static_cast<void>(error);
@@ -336,6 +487,224 @@ public:
     /// the caller-provided error handler specifies whether an attempt is made
     /// to continue. See the @c onError() documentation for details.
     static void readFromMemory(std::string_view pgn, PgnReaderActions &actions, PgnReaderActionFilter filter);
+
+    /// @brief Finds the next plausible game start in a PGN
+    ///
+    /// @param[in]  pgn          PGN contents
+    /// @param[in]  pos          Search start position
+    /// @return                  Offset of the game start, or @c pgn.size() if
+    ///                          not found
+    ///
+    /// A plausible game start is a line that begins with @c '[' and is not
+    /// preceded by another line beginning with @c '['. That is, the rest of
+    /// the current tag pair section is skipped. LF, CRLF, and CR line endings
+    /// are recognized. This is the same rule that the reader uses for
+    /// resynchronizing after errors.
+    ///
+    /// The input is not tokenized, so a line beginning with @c '[' inside a
+    /// multi-line comment is also a plausible game start.
+    static std::size_t findNextGameStart(std::string_view pgn, std::size_t pos) noexcept;
+};
+
+/// @brief PGN tag of a game read with @coderef{PgnGameReader}
+struct PgnGameTag
+{
+    /// @brief Key of the PGN tag
+    std::string_view key;
+
+    /// @brief Value of the PGN tag
+    std::string_view value;
+};
+
+/// @brief Comment of a game read with @coderef{PgnGameReader}
+struct PgnGameComment
+{
+    /// @brief Number of mainline moves played before the comment. That is,
+    /// @c 0 for comments before the first move, @c 1 for comments after the
+    /// first move, and so on.
+    std::size_t moveIndex;
+
+    /// @brief Comment text
+    std::string_view text;
+};
+
+/// @brief Lightweight view to a game read with @coderef{PgnGameReader}
+///
+/// The view and the data it refers to are owned by the reader. They remain
+/// valid until the next call to @coderef{PgnGameReader::nextGame()} or until
+/// the reader is destroyed.
+struct PgnGameView
+{
+    /// @brief PGN tags in the order they appear in the game
+    std::span<const PgnGameTag> tags;
+
+    /// @brief Starting position of the game
+    const ChessBoard *initialBoard;
+
+    /// @brief Mainline moves
+    std::span<const Move> moves;
+
+    /// @brief Mainline comments, including the comments preceding the PGN
+    /// tags, in the order they appear in the game
+    std::span<const PgnGameComment> comments;
+
+    /// @brief Game result
+    PgnResult result;
+
+    /// @brief Byte offset of the game in the input
+    std::uint64_t inputOffset;
+
+    /// @brief Length of the game in the input, including the game
+    /// termination marker
+    std::uint64_t inputLength;
+};
+
+/// @brief Pull-style PGN reader that reads one game at a time
+///
+/// This is an alternative to @coderef{PgnReader::readFromMemory()} for
+/// consumers that process whole games. Mainline moves are validated. Variations
+/// and NAGs are skipped, and comments within variations are omitted. The
+/// reader uses internal buffers that are reused between games.
+///
+/// Example:
+/// @code
+/// PgnGameReader reader { pgn };
+///
+/// for (const PgnGameView &game : reader)
+/// {
+///     for (const PgnGameTag &tag : game.tags)
+///         std::cout << tag.key << ": " << tag.value << std::endl;
+///
+///     std::cout << "Number of moves: " << game.moves.size() << std::endl;
+/// }
+/// @endcode
+class PgnGameReader
+{
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+
+public:
+    /// @brief Input iterator over the games of a @coderef{PgnGameReader}
+    ///
+    /// Incrementing the iterator reads the next game. The end of input is
+    /// signaled by comparing equal to @c std::default_sentinel.
+    class Iterator
+    {
+    private:
+        PgnGameReader *m_reader { };
+        bool m_atEnd { true };
+
+    public:
+        /// @brief Value type
+        using value_type = PgnGameView;
+
+        /// @brief Difference type
+        using difference_type = std::ptrdiff_t;
+
+        /// @brief Constructor (end iterator)
+        Iterator() = default;
+
+        /// @brief Constructor. Reads the first game.
+        ///
+        /// @param[in]  reader    Game reader
+        /// @throws PgnError      PGN processing failed
+        explicit Iterator(PgnGameReader &reader) :
+            m_reader { &reader },
+            m_atEnd { !reader.nextGame() }
+        {
+        }
+
+        /// @brief Returns the current game
+        ///
+        /// @return   Current game
+        const PgnGameView &operator * () const noexcept
+        {
+            return m_reader->getGame();
+        }
+
+        /// @brief Reads the next game
+        ///
+        /// @return   Reference to this iterator
+        /// @throws PgnError      PGN processing failed
+        Iterator &operator ++ ()
+        {
+            m_atEnd = !m_reader->nextGame();
+            return *this;
+        }
+
+        /// @brief Reads the next game
+        ///
+        /// @throws PgnError      PGN processing failed
+        void operator ++ (int)
+        {
+            ++*this;
+        }
+
+        /// @brief Checks for end of input
+        ///
+        /// @return   Whether there are no more games
+        bool operator == (std::default_sentinel_t) const noexcept
+        {
+            return m_atEnd;
+        }
+    };
+
+    /// @brief Constructor
+    ///
+    /// @param[in]  pgn     PGN contents. Must remain valid for the lifetime of
+    ///                     the reader.
+    explicit PgnGameReader(std::string_view pgn);
+
+    /// @brief Destructor
+    ~PgnGameReader();
+
+    /// @brief Copy constructor (deleted)
+    PgnGameReader(const PgnGameReader &) = delete;
+
+    /// @brief Move constructor (deleted)
+    PgnGameReader(PgnGameReader &&) = delete;
+
+    /// @brief Copy assignment (deleted)
+    PgnGameReader &operator = (const PgnGameReader &) & = delete;
+
+    /// @brief Move assignment (deleted)
+    PgnGameReader &operator = (PgnGameReader &&) & = delete;
+
+    /// @brief Reads the next game
+    ///
+    /// @return                  @true if a game was read and is available
+    ///                          with @coderef{getGame()}. @false at the end of
+    ///                          input.
+    /// @throws PgnError         PGN processing failed
+    ///
+    /// In case of @coderef{PgnError}, the erroneous game is skipped. The next
+    /// call continues from the following game.
+    bool nextGame();
+
+    /// @brief Returns the most recently read game
+    ///
+    /// @return   View to the game
+    ///
+    /// @pre The latest call to @coderef{nextGame()} returned @true.
+    const PgnGameView &getGame() const noexcept;
+
+    /// @brief Returns an iterator that reads the first game
+    ///
+    /// @return   Iterator to the first game
+    /// @throws PgnError      PGN processing failed
+    Iterator begin()
+    {
+        return Iterator { *this };
+    }
+
+    /// @brief Returns the end sentinel
+    ///
+    /// @return   End sentinel
+    std::default_sentinel_t end() const noexcept
+    {
+        return std::default_sentinel;
+    }
 };
 
 /// @}
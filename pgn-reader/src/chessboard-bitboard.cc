@@ -66,6 +66,34 @@ static constexpr inline RowColumn getRookColumnAfterCastling(MoveTypeAndPromotio
     return 5U - (static_cast<RowColumn>(typeAndPromo) & 1U) * 2U;
 }
 
+// Returns whether the first piece from the king towards sq is a slider that
+// checks the king. Only sliders that move along the line are considered,
+// i.e., rooks for ranks and files, and bishops for diagonals.
+inline bool isLineCheck(
+    Square kingSq,
+    Square sq,
+    SquareSet occupancyMask,
+    SquareSet bishops,
+    SquareSet rooks) noexcept
+{
+    const SquareSet ray { ctBitBoardTables.raysFromKing[getIndexOfSquare(kingSq)][getIndexOfSquare(sq)] };
+
+    // not on a line with the king?
+    if (ray == SquareSet { }) [[likely]]
+        return false;
+
+    const bool orthogonal { rowOf(kingSq) == rowOf(sq) || columnOf(kingSq) == columnOf(sq) };
+    const SquareSet sliders { (orthogonal ? rooks : bishops) & ray };
+
+    if (sliders == SquareSet { })
+        return false;
+
+    // nearest slider to the king on the ray
+    const Square sliderSq { sq > kingSq ? sliders.firstSquare() : sliders.lastSquare() };
+
+    return (Intercepts::getInterceptSquares(kingSq, sliderSq) & occupancyMask) == SquareSet { sliderSq };
+}
+
 }
 
 void ChessBoard::updateCheckersAndPins() noexcept
@@ -357,4 +385,231 @@ void ChessBoard::doMove(const Move m) noexcept
     updateCheckersAndPins();
 }
 
+void ChessBoard::doMove(const Move m, MoveUndoInfo &undoInfo) noexcept
+{
+    // note: castling is encoded as king-captures-own-rook
+    undoInfo.capturedPiece = m.isCastlingMove() ? Piece::NONE : getSquarePieceNoColor(m.getDst());
+    undoInfo.epSquare = m_epSquare;
+    undoInfo.halfMoveClock = m_halfMoveClock;
+    undoInfo.castlingRooks = m_castlingRooks;
+
+    doMove(m);
+}
+
+void ChessBoard::undoMove(const Move m, const MoveUndoInfo &undoInfo) noexcept
+{
+    // switch sides back
+    --m_plyNum;
+    std::swap(m_kingSq, m_oppKingSq);
+    m_turnColorMask = (~m_turnColorMask) & m_occupancyMask;
+
+    const SquareSet srcSqBit { m.getSrc() };
+    const SquareSet dstSqBit { m.getDst() };
+
+    if (m.isCastlingMove())
+    {
+        const RowColumn row { rowOf(m.getSrc()) };
+        const Square kingSqAfterCastling { makeSquare(getKingColumnAfterCastling(m.getTypeAndPromotion()), row) };
+        const Square rookSqAfterCastling { makeSquare(getRookColumnAfterCastling(m.getTypeAndPromotion()), row) };
+
+        const SquareSet afterCastlingBits { SquareSet { kingSqAfterCastling } | SquareSet { rookSqAfterCastling } };
+
+        // clear first, since the squares before and after castling may overlap
+        m_occupancyMask &=~ afterCastlingBits;
+        m_occupancyMask |=  srcSqBit | dstSqBit;
+
+        m_turnColorMask &=~ afterCastlingBits;
+        m_turnColorMask |=  srcSqBit | dstSqBit;
+
+        m_kings &=~ SquareSet { kingSqAfterCastling };
+        m_kings |=  srcSqBit;
+        m_rooks &=~ SquareSet { rookSqAfterCastling };
+        m_rooks |=  dstSqBit;
+
+        m_kingSq = m.getSrc();
+    }
+    else
+    {
+        const SquareSet moveBits { srcSqBit | dstSqBit };
+
+        switch (m.getTypeAndPromotion())
+        {
+            case MoveTypeAndPromotion::REGULAR_PAWN_MOVE:
+                m_pawns   ^= moveBits;
+                break;
+
+            case MoveTypeAndPromotion::REGULAR_KNIGHT_MOVE:
+                m_knights ^= moveBits;
+                break;
+
+            case MoveTypeAndPromotion::REGULAR_BISHOP_MOVE:
+                m_bishops ^= moveBits;
+                break;
+
+            case MoveTypeAndPromotion::REGULAR_ROOK_MOVE:
+                m_rooks   ^= moveBits;
+                break;
+
+            case MoveTypeAndPromotion::REGULAR_QUEEN_MOVE:
+                m_bishops ^= moveBits;
+                m_rooks   ^= moveBits;
+                break;
+
+            case MoveTypeAndPromotion::REGULAR_KING_MOVE:
+                m_kings   ^= moveBits;
+                m_kingSq = m.getSrc();
+                break;
+
+            case MoveTypeAndPromotion::EN_PASSANT:
+            {
+                const SquareSet epSqBit { makeSquare(columnOf(m.getDst()), rowOf(m.getSrc())) };
+
+                m_pawns         ^= moveBits;
+                m_pawns         |= epSqBit;
+                m_occupancyMask |= epSqBit;
+                break;
+            }
+
+            default:
+                assert(m.isPromotionMove());
+
+                m_knights &=~ dstSqBit;
+                m_bishops &=~ dstSqBit;
+                m_rooks   &=~ dstSqBit;
+                m_pawns   |=  srcSqBit;
+                break;
+        }
+
+        m_occupancyMask &=~ dstSqBit;
+        m_occupancyMask |=  srcSqBit;
+
+        m_turnColorMask &=~ dstSqBit;
+        m_turnColorMask |=  srcSqBit;
+
+        // put back the captured piece
+        if (undoInfo.capturedPiece != Piece::NONE)
+        {
+            m_occupancyMask |= dstSqBit;
+
+            switch (undoInfo.capturedPiece)
+            {
+                case Piece::PAWN:
+                    m_pawns   |= dstSqBit;
+                    break;
+
+                case Piece::KNIGHT:
+                    m_knights |= dstSqBit;
+                    break;
+
+                case Piece::BISHOP:
+                    m_bishops |= dstSqBit;
+                    break;
+
+                case Piece::ROOK:
+                    m_rooks   |= dstSqBit;
+                    break;
+
+                default:
+                    assert(undoInfo.capturedPiece == Piece::QUEEN);
+                    m_bishops |= dstSqBit;
+                    m_rooks   |= dstSqBit;
+                    break;
+            }
+        }
+    }
+
+    m_castlingRooks = undoInfo.castlingRooks;
+    m_epSquare = undoInfo.epSquare;
+    m_halfMoveClock = undoInfo.halfMoveClock;
+
+    updateCheckersAndPins();
+}
+
+bool ChessBoard::givesCheck(const Move m) const noexcept
+{
+    const SquareSet srcSqBit { m.getSrc() };
+    const SquareSet dstSqBit { m.getDst() };
+    const SquareSet oppKingBit { m_oppKingSq };
+
+    // Sliders that may give a discovered check. The moving piece is checked
+    // separately on its destination square.
+    const SquareSet bishops { m_bishops & m_turnColorMask &~ srcSqBit };
+    const SquareSet rooks { m_rooks & m_turnColorMask &~ srcSqBit };
+
+    if (m.isCastlingMove()) [[unlikely]]
+    {
+        const RowColumn row { rowOf(m.getSrc()) };
+        const Square kingSqAfterCastling { makeSquare(getKingColumnAfterCastling(m.getTypeAndPromotion()), row) };
+        const Square rookSqAfterCastling { makeSquare(getRookColumnAfterCastling(m.getTypeAndPromotion()), row) };
+
+        const SquareSet occupancyMaskAfter {
+            (m_occupancyMask &~ (srcSqBit | dstSqBit)) |
+            SquareSet { kingSqAfterCastling } | SquareSet { rookSqAfterCastling } };
+
+        // Only the castled rook can check directly. Note that the castling
+        // rook is encoded as the destination square.
+        return
+            isLineCheck(m_oppKingSq, rookSqAfterCastling, occupancyMaskAfter, SquareSet { }, SquareSet { rookSqAfterCastling }) ||
+            isLineCheck(m_oppKingSq, m.getSrc(), occupancyMaskAfter, bishops, rooks &~ dstSqBit) ||
+            isLineCheck(m_oppKingSq, m.getDst(), occupancyMaskAfter, bishops, rooks &~ dstSqBit);
+    }
+
+    SquareSet occupancyMaskAfter { (m_occupancyMask &~ srcSqBit) | dstSqBit };
+    SquareSet movedBishop { };
+    SquareSet movedRook { };
+
+    switch (m.getTypeAndPromotion())
+    {
+        case MoveTypeAndPromotion::REGULAR_PAWN_MOVE:
+            if ((Attacks::getPawnAttackMask(m.getDst(), getTurn()) & oppKingBit) != SquareSet { })
+                return true;
+            break;
+
+        case MoveTypeAndPromotion::EN_PASSANT:
+        {
+            if ((Attacks::getPawnAttackMask(m.getDst(), getTurn()) & oppKingBit) != SquareSet { })
+                return true;
+
+            // the captured pawn may also reveal a check
+            const Square capturedPawnSq { makeSquare(columnOf(m.getDst()), rowOf(m.getSrc())) };
+            occupancyMaskAfter &=~ SquareSet { capturedPawnSq };
+
+            if (isLineCheck(m_oppKingSq, capturedPawnSq, occupancyMaskAfter, bishops, rooks))
+                return true;
+
+            break;
+        }
+
+        case MoveTypeAndPromotion::REGULAR_KNIGHT_MOVE:
+        case MoveTypeAndPromotion::PROMO_KNIGHT:
+            if ((Attacks::getKnightAttackMask(m.getDst()) & oppKingBit) != SquareSet { })
+                return true;
+            break;
+
+        case MoveTypeAndPromotion::REGULAR_BISHOP_MOVE:
+        case MoveTypeAndPromotion::PROMO_BISHOP:
+            movedBishop = dstSqBit;
+            break;
+
+        case MoveTypeAndPromotion::REGULAR_ROOK_MOVE:
+        case MoveTypeAndPromotion::PROMO_ROOK:
+            movedRook = dstSqBit;
+            break;
+
+        case MoveTypeAndPromotion::REGULAR_QUEEN_MOVE:
+        case MoveTypeAndPromotion::PROMO_QUEEN:
+            movedBishop = dstSqBit;
+            movedRook = dstSqBit;
+            break;
+
+        default:
+            assert(m.getTypeAndPromotion() == MoveTypeAndPromotion::REGULAR_KING_MOVE);
+            break;
+    }
+
+    return
+        isLineCheck(m_oppKingSq, m.getDst(), occupancyMaskAfter, movedBishop, movedRook) ||
+        isLineCheck(m_oppKingSq, m.getSrc(), occupancyMaskAfter, bishops, rooks);
+}
+
 }
@@ -30,6 +30,7 @@
 #include <iterator>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace hoover_chess_utils::pgn_reader
@@ -324,6 +325,26 @@ public:
     void endOfPGN() { }
 };
 
+/// @brief Result of @coderef{PgnParser::parseGame()}
+enum class PgnParserGameResult : std::uint8_t
+{
+    /// @brief A game was parsed
+    GAME,
+
+    /// @brief The action handler recorded an error. The game was abandoned.
+    ///
+    /// Action handlers may optionally provide <tt>bool hasPendingError() const</tt>
+    /// and <tt>PgnError &getPendingError()</tt>. The parser then checks for a
+    /// pending error after every move and move number, and on an error, it
+    /// abandons the game without invoking further actions. This way,
+    /// rejecting a move does not need an exception to unwind the parser. The
+    /// parser sets the error location in the pending error.
+    PENDING_ERROR,
+
+    /// @brief End of input was reached, and @c endOfPGN() has been invoked
+    END_OF_INPUT,
+};
+
 /// @brief The PGN parser
 ///
 /// @tparam T_ActionHandler     Semantic action handler. See @coderef{PgnParser_NullActions} for description.
@@ -477,11 +498,21 @@ private:
     PgnScanner &m_scanner;
     T_ActionHandler &m_actionHandler;
     StringBuilder m_strBuilder { };
-    StringBuilder m_strBuilder2 { };
 
     bool m_inMoveTextSection { };
     std::vector<std::string> m_pendingComments { };
 
+    static constexpr bool ctHasPendingErrors {
+        requires (T_ActionHandler &handler) { handler.hasPendingError(); } };
+
+    inline bool hasPendingError() const noexcept
+    {
+        if constexpr (ctHasPendingErrors)
+            return m_actionHandler.hasPendingError();
+        else
+            return false;
+    }
+
     void unexpectedTokenError(
         PgnErrorCode errorCode,
         std::uint32_t expectedTokenMask,
@@ -507,8 +538,6 @@ private:
 
     void parseTagPair()
     {
-        m_strBuilder.clear();
-        m_strBuilder2.clear();
         PgnScannerToken token { m_scanner.nextToken() };
         if (token != PgnScannerToken::TAG_KEY) [[unlikely]]
             unexpectedTokenError(
@@ -516,7 +545,8 @@ private:
                 pgnScannerTokenToMaskBit(PgnScannerToken::TAG_KEY),
                 token);
 
-        m_strBuilder.appendString(m_scanner.YYText(), m_scanner.YYLeng());
+        // note: the input views remain valid over the following tokens
+        const std::string_view key { m_scanner.getTokenInputView() };
 
         token = m_scanner.nextToken();
         if (token != PgnScannerToken::TAG_VALUE) [[unlikely]]
@@ -526,33 +556,50 @@ private:
                 token);
 
         // TAG value string has format "...", so we'll crop the first and the
-        // last chars away. In addition, we need to parse escapes
+        // last chars away
+        const std::string_view quotedValue { m_scanner.getTokenInputView() };
+        const std::string_view value { quotedValue.substr(1U, quotedValue.size() - 2U) };
+
+        // Escapes are rare, so we'll pass the value directly from the input
+        // unless there are any. The search is done by memchr(), which is
+        // vectorized in the common C libraries.
+        const char *const firstEscape { static_cast<const char *>(std::memchr(value.data(), '\\', value.size())) };
+
+        if (firstEscape == nullptr) [[likely]]
+            m_actionHandler.pgnTag(key, value);
+        else
+            m_actionHandler.pgnTag(key, unescapeTagValue(value, firstEscape));
+
+        token = m_scanner.nextToken();
+        if (token != PgnScannerToken::TAG_END) [[unlikely]]
+            unexpectedTokenError(
+                PgnErrorCode::BAD_PGN_TAG,
+                pgnScannerTokenToMaskBit(PgnScannerToken::TAG_END),
+                token);
+    }
+
+    std::string_view unescapeTagValue(std::string_view value, const char *firstEscape)
+    {
+        m_strBuilder.clear();
+        m_strBuilder.appendString(value.data(), static_cast<std::size_t>(firstEscape - value.data()));
+
         bool escape = false;
-        for (const char c : std::string_view { m_scanner.YYText() + 1, static_cast<std::size_t>(m_scanner.YYLeng() - 2) })
+        for (const char c : std::string_view { firstEscape, value.data() + value.size() })
         {
             if (escape)
             {
-                m_strBuilder2.pushBack(c);
+                m_strBuilder.pushBack(c);
                 escape = false;
             }
             else if (c != '\\')
             {
-                m_strBuilder2.pushBack(c);
+                m_strBuilder.pushBack(c);
             }
             else
                 escape = true;
         }
 
-        m_actionHandler.pgnTag(
-            m_strBuilder.getStringView(),
-            m_strBuilder2.getStringView());
-
-        token = m_scanner.nextToken();
-        if (token != PgnScannerToken::TAG_END) [[unlikely]]
-            unexpectedTokenError(
-                PgnErrorCode::BAD_PGN_TAG,
-                pgnScannerTokenToMaskBit(PgnScannerToken::TAG_END),
-                token);
+        return m_strBuilder.getStringView();
     }
 
     PgnScannerToken parseLine(PgnScannerToken token)
@@ -565,6 +612,10 @@ private:
             {
                 case PgnScannerToken::MOVENUM:
                     handleMoveNum(m_scanner.getTokenInfo().moveNum);
+
+                    if (hasPendingError()) [[unlikely]]
+                        return PgnScannerToken::ERROR;
+
                     token = m_scanner.nextToken();
                     break;
 
@@ -673,6 +724,9 @@ private:
 
         if (token != PgnScannerToken::VARIATION_END) [[unlikely]]
         {
+            if (hasPendingError())
+                return PgnScannerToken::ERROR;
+
             unexpectedTokenError(
                 PgnErrorCode::UNEXPECTED_TOKEN,
                 pgnScannerTokenToMaskBit(PgnScannerToken::VARIATION_END),
@@ -756,6 +810,10 @@ private:
 
     PgnScannerToken parseNagsAfterMove()
     {
+        // the move was rejected by the action handler
+        if (hasPendingError()) [[unlikely]]
+            return PgnScannerToken::ERROR;
+
         PgnScannerToken token { m_scanner.nextToken() };
 
         while (token == PgnScannerToken::NAG)
@@ -791,7 +849,10 @@ private:
 
     void parseCommentBlock()
     {
-        m_strBuilder.clear();
+        // A comment that fits in a single text token is passed directly from
+        // the input. Otherwise, the text tokens are joined in the builder.
+        std::string_view text { };
+        bool textInBuilder { };
 
         std::size_t pendingNewlines { };
 
@@ -801,25 +862,40 @@ private:
             switch (token)
             {
                 case PgnScannerToken::COMMENT_TEXT:
-                    if (!m_strBuilder.isEmpty())
+                    if (text.empty())
+                    {
+                        // note: text tokens are never empty
+                        text = m_scanner.getTokenInputView();
+                    }
+                    else
                     {
+                        if (!textInBuilder)
+                        {
+                            m_strBuilder.clear();
+                            m_strBuilder.appendString(text.data(), text.size());
+                            textInBuilder = true;
+                        }
+
                         while (pendingNewlines > 0U)
                         {
                             m_strBuilder.pushBack('\n');
                             --pendingNewlines;
                         }
+                        m_strBuilder.appendString(m_scanner.YYText(), m_scanner.YYLeng());
                     }
                     pendingNewlines = 0U;
-                    m_strBuilder.appendString(m_scanner.YYText(), m_scanner.YYLeng());
                     break;
                 case PgnScannerToken::COMMENT_NEWLINE:
                     ++pendingNewlines;
                     break;
                 case PgnScannerToken::COMMENT_END:
+                    if (textInBuilder)
+                        text = m_strBuilder.getStringView();
+
                     if (m_inMoveTextSection)
-                        m_actionHandler.comment(m_strBuilder.getStringView());
+                        m_actionHandler.comment(text);
                     else
-                        m_pendingComments.push_back(std::string { m_strBuilder.getStringView() });
+                        m_pendingComments.push_back(std::string { text });
 
                     return;
 
@@ -908,76 +984,121 @@ public:
     PgnParser &operator = (const PgnParser &) & = delete;
     PgnParser &operator = (PgnParser &&) & = delete;
 
-    void parse()
+    /// @brief Parses the next game
+    ///
+    /// @return  Parse result
+    ///
+    /// The action handler is invoked for the game as with @coderef{parse()}.
+    PgnParserGameResult parseGame()
     {
         try
         {
-            // every full iteration parses a game
+            PgnScannerToken token { m_scanner.nextToken() };
+
+            // PGN ==> GAME* COMMENT* <end_of_file>
             while (true)
             {
-                PgnScannerToken token { m_scanner.nextToken() };
-
-                // PGN ==> GAME* COMMENT* <end_of_file>
-                while (true)
+                if (token == PgnScannerToken::END_OF_FILE)
                 {
-                    if (token == PgnScannerToken::END_OF_FILE)
-                    {
-                        flushPendingComments();
-                        m_actionHandler.endOfPGN();
-                        return;
-                    }
-                    else if (token == PgnScannerToken::COMMENT_START)
-                        parseCommentBlock();
-                    else if (token == PgnScannerToken::COMMENT_TEXT)
-                        parseSingleLineComment();
-                    else
-                        break;
-
-                    token = m_scanner.nextToken();
+                    flushPendingComments();
+                    m_actionHandler.endOfPGN();
+                    return PgnParserGameResult::END_OF_INPUT;
                 }
+                else if (token == PgnScannerToken::COMMENT_START)
+                    parseCommentBlock();
+                else if (token == PgnScannerToken::COMMENT_TEXT)
+                    parseSingleLineComment();
+                else
+                    break;
 
-                // GAME = TAGPAIRS MOVETEXT
-                m_actionHandler.gameStart();
+                token = m_scanner.nextToken();
+            }
 
-                // TAGPAIRS = (COMMENT | TAGPAIR)*
-                while (true)
-                {
-                    if (token == PgnScannerToken::TAG_START)
-                    {
-                        flushPendingComments();
-                        parseTagPair();
-                    }
-                    else if (token == PgnScannerToken::COMMENT_START)
-                        parseCommentBlock();
-                    else if (token == PgnScannerToken::COMMENT_TEXT)
-                        parseSingleLineComment();
-                    else
-                        break;
+            // GAME = TAGPAIRS MOVETEXT
+            m_actionHandler.gameStart();
 
-                    token = m_scanner.nextToken();
+            // TAGPAIRS = (COMMENT | TAGPAIR)*
+            while (true)
+            {
+                if (token == PgnScannerToken::TAG_START)
+                {
+                    flushPendingComments();
+                    parseTagPair();
                 }
+                else if (token == PgnScannerToken::COMMENT_START)
+                    parseCommentBlock();
+                else if (token == PgnScannerToken::COMMENT_TEXT)
+                    parseSingleLineComment();
+                else
+                    break;
 
-                // MOVETEXT
-                m_actionHandler.moveTextSection();
-                flushPendingComments();
-                m_inMoveTextSection = true;
+                token = m_scanner.nextToken();
+            }
 
-                token = parseLine(token);
+            // MOVETEXT
+            m_actionHandler.moveTextSection();
+            flushPendingComments();
+            m_inMoveTextSection = true;
 
-                if (token != PgnScannerToken::RESULT) [[unlikely]]
-                    unexpectedTokenError(
-                        PgnErrorCode::UNEXPECTED_TOKEN,
-                        pgnScannerTokenToMaskBit(PgnScannerToken::RESULT),
-                        token);
+            token = parseLine(token);
+
+            if (token != PgnScannerToken::RESULT) [[unlikely]]
+            {
+                if (hasPendingError())
+                {
+                    // the scanner is still at the token of the rejected move
+                    if constexpr (ctHasPendingErrors)
+                        m_actionHandler.getPendingError().setLocation(m_scanner.getLineNumber(), m_scanner.getTokenStartOffset());
+
+                    return PgnParserGameResult::PENDING_ERROR;
+                }
 
-                m_actionHandler.gameTerminated(m_scanner.getTokenInfo().result.result);
-                m_inMoveTextSection = false;
+                unexpectedTokenError(
+                    PgnErrorCode::UNEXPECTED_TOKEN,
+                    pgnScannerTokenToMaskBit(PgnScannerToken::RESULT),
+                    token);
             }
+
+            m_actionHandler.gameTerminated(m_scanner.getTokenInfo().result.result);
+            m_inMoveTextSection = false;
+
+            return PgnParserGameResult::GAME;
+        }
+        catch (PgnError &ex)
+        {
+            // add position info in the exception and rethrow it as is
+            ex.setLocation(m_scanner.getLineNumber(), m_scanner.getTokenStartOffset());
+            throw;
         }
-        catch (const PgnError &ex)
+    }
+
+    /// @brief Discards the state of a partially parsed game. This is intended
+    /// for error recovery, after the scanner has been moved to the start of
+    /// the next game.
+    ///
+    /// @sa @coderef{PgnScanner::skipToNextGame()}
+    void abortGame() noexcept
+    {
+        m_inMoveTextSection = false;
+        m_pendingComments.clear();
+    }
+
+    /// @brief Parses the whole PGN input
+    void parse()
+    {
+        // every iteration parses a game
+        while (true)
         {
-            // add position info in the exception
-            throw PgnError(m_scanner, ex);
+            const PgnParserGameResult result { parseGame() };
+
+            if (result == PgnParserGameResult::END_OF_INPUT)
+                break;
+
+            if constexpr (ctHasPendingErrors)
+            {
+                if (result == PgnParserGameResult::PENDING_ERROR) [[unlikely]]
+                    throw PgnError { m_actionHandler.getPendingError() };
+            }
         }
     }
 };
@@ -15,9 +15,11 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "pgnreader-error.h"
+#include "pgnreader-string-utils.h"
 #include "pgnscanner.h"
 
 #include <format>
+#include <string>
 #include <string_view>
 
 namespace hoover_chess_utils::pgn_reader
@@ -43,15 +45,104 @@ std::string_view PgnError::getStringForCode(PgnErrorCode code) noexcept
 }
 
 PgnError::PgnError(PgnErrorCode code, std::string_view details) :
-    m_str { std::format("Error {} ({}): {}", static_cast<unsigned>(code), getStringForCode(code), details) },
-    m_code { code }
+    m_details { details },
+    m_code { code },
+    m_detailsType { DetailsType::TEXT }
+{
+}
+
+PgnError::PgnError(PgnErrorCode code, const PgnErrorMoveInfo &moveInfo) noexcept :
+    m_moveInfo { moveInfo },
+    m_code { code },
+    m_detailsType { DetailsType::MOVE }
+{
+}
+
+PgnError::PgnError(std::uint32_t expectedMoveNum, std::uint32_t actualMoveNum) noexcept :
+    m_expectedMoveNum { expectedMoveNum },
+    m_actualMoveNum { actualMoveNum },
+    m_code { PgnErrorCode::UNEXPECTED_MOVE_NUM },
+    m_detailsType { DetailsType::MOVE_NUM }
 {
 }
 
 PgnError::PgnError(const PgnScanner &scanner, const PgnError &ex) :
-    m_str { std::format("Line {}: {}", scanner.lineno(), ex.m_str) },
-    m_code { ex.m_code }
+    PgnError { ex }
 {
+    setLocation(scanner.getLineNumber(), scanner.getTokenStartOffset());
+}
+
+std::string PgnError::formatMessage() const
+{
+    std::string details { };
+
+    switch (m_detailsType)
+    {
+        case DetailsType::TEXT:
+            details = m_details;
+            break;
+
+        case DetailsType::MOVE:
+        {
+            const MiniString<13U> moveNumStr {
+                StringUtils::moveNumToString(moveNumOfPly(m_moveInfo.plyNum), colorOfPly(m_moveInfo.plyNum)) };
+
+            if (m_moveInfo.dst == Square::NONE)
+            {
+                details = std::format("{} {}", moveNumStr.getStringView(), m_moveInfo.shortCastle ? "O-O" : "O-O-O");
+            }
+            else
+            {
+                MiniString<2U> promoStr;
+                if (m_moveInfo.promo != Piece::NONE)
+                {
+                    promoStr.setLength(2U);
+                    promoStr[0U] = '=';
+                    promoStr[1U] = StringUtils::promoPieceChar(m_moveInfo.promo);
+                }
+
+                details = std::format(
+                    "{} {}{}{}{}{}{}",
+                    moveNumStr.getStringView(),
+                    StringUtils::pieceToSanStr(m_moveInfo.piece).getStringView(),
+                    StringUtils::sourceMaskToString(m_moveInfo.srcMask).getStringView(),
+                    m_moveInfo.capture ? std::string_view { "x" } : std::string_view { },
+                    StringUtils::colChar(m_moveInfo.dst),
+                    StringUtils::rowChar(m_moveInfo.dst),
+                    promoStr.getStringView());
+            }
+            break;
+        }
+
+        case DetailsType::MOVE_NUM:
+            details = std::format("Expected move {} but got {}", m_expectedMoveNum, m_actualMoveNum);
+            break;
+    }
+
+    std::string ret {
+        std::format("Error {} ({}): {}", static_cast<unsigned>(m_code), getStringForCode(m_code), details) };
+
+    if (m_lineNumber != 0U)
+        ret = std::format("Line {}: {}", m_lineNumber, ret);
+
+    return ret;
+}
+
+const char *PgnError::what() const noexcept
+{
+    if (m_str.empty()) [[unlikely]]
+    {
+        try
+        {
+            m_str = formatMessage();
+        }
+        catch (...)
+        {
+            return "PgnError: failed to format the error message";
+        }
+    }
+
+    return m_str.c_str();
 }
 
 }
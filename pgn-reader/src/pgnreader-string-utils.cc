@@ -178,11 +178,8 @@ MiniString<2U> StringUtils::sourceMaskToString(SquareSet srcMask) noexcept
     return ret;
 }
 
-MiniString<7U> StringUtils::moveToSanAndPlay(ChessBoard &board, Move move)
+char *StringUtils::moveToSanBody(const ChessBoard &board, Move move, char *i)
 {
-    MiniString<7U> ret { MiniString_Uninitialized() };
-    char *i { ret.data() };
-
     const SquareSet srcBit { move.getSrc() };
 
     ShortMoveList moves;
@@ -329,6 +326,14 @@ MiniString<7U> StringUtils::moveToSanAndPlay(ChessBoard &board, Move move)
                 move.getEncodedValue()));
     }
 
+    return i;
+}
+
+MiniString<7U> StringUtils::moveToSanAndPlay(ChessBoard &board, Move move)
+{
+    MiniString<7U> ret { MiniString_Uninitialized() };
+    char *i { moveToSanBody(board, move, ret.data()) };
+
     // now play it
     board.doMove(move);
 
@@ -348,6 +353,29 @@ MiniString<7U> StringUtils::moveToSanAndPlay(ChessBoard &board, Move move)
     return ret;
 }
 
+MiniString<7U> StringUtils::moveToSan(const ChessBoard &board, Move move)
+{
+    MiniString<7U> ret { MiniString_Uninitialized() };
+    char *i { moveToSanBody(board, move, ret.data()) };
+
+    // The board needs to be copied and the move played only for the mate
+    // test, which is needed only for checks
+    if (board.givesCheck(move))
+    {
+        ChessBoard tmpBoard { board };
+        tmpBoard.doMove(move);
+
+        if (tmpBoard.hasLegalMoves())
+            *i++ = '+';
+        else
+            *i++ = '#';
+    }
+
+    ret.setLength(i - ret.data());
+
+    return ret;
+}
+
 std::string_view StringUtils::pieceAndColorToString(PieceAndColor pc) noexcept
 {
     std::size_t i { static_cast<std::size_t>(pc) };
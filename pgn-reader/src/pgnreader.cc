@@ -22,22 +22,25 @@
 #include "pgnreader-string-utils.h"
 #include "pgnscanner.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdint>
 #include <format>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace hoover_chess_utils::pgn_reader
 {
 
-namespace
-{
-
 /// @brief PGN reader parser actions
 ///
 /// @tparam CompileTimeMinFilter     Actions that are guaranteed to be enabled
 /// @tparam CompileTimeMaxFilter     Actions that can be enabled
-template <typename CompileTimeMinFilter, typename CompileTimeMaxFilter>
+/// @tparam T_Actions                Semantic actions type. When this is a final
+///                                  class, the callbacks are devirtualized.
+template <typename CompileTimeMinFilter, typename CompileTimeMaxFilter, typename T_Actions = PgnReaderActions>
 class PgnReaderParserActions
 {
 private:
@@ -51,19 +54,41 @@ private:
     ChessBoard m_board { };
     ChessBoard m_prevBoard { };
 
-    struct SaveState
+    struct MoveAndUndoInfo
     {
-        ChessBoard m_board { };
-        ChessBoard m_prevBoard { };
+        Move move { Move::illegalNoMove() };
+        MoveUndoInfo undoInfo { };
     };
 
-    std::array<SaveState, ctMaxVariationLevel> m_variationParentStack { };
+    // Last move of the current line. A variation replaces this move.
+    MoveAndUndoInfo m_lastMove { };
+
+    // Moves played in variations (level > 0) for undoing them when returning
+    // to the parent line. Mainline moves are not recorded.
+    std::vector<MoveAndUndoInfo> m_variationMoves { };
+
+    struct VariationParent
+    {
+        // last move of the parent line, replayed at the variation end
+        MoveAndUndoInfo lastMove { };
+
+        // size of m_variationMoves at the variation start
+        std::size_t numVariationMoves { };
+    };
+
+    std::array<VariationParent, ctMaxVariationLevel> m_variationParentStack { };
     std::uint32_t m_variationLevel { };
 
-    PgnReaderActions &m_actions;
+    T_Actions &m_actions;
     PgnReaderActionFilter m_filter { };
 
     PgnScanner const &m_pgnScanner;
+    PgnInputLocation m_inputLocation;
+
+    // Move validation errors are recorded here instead of throwing them, so
+    // that rejecting a move does not unwind the parser. See
+    // PgnParserGameResult::PENDING_ERROR.
+    std::optional<PgnError> m_pendingError { };
 
 
     template <PgnReaderActionClass action>
@@ -92,24 +117,7 @@ private:
     {
         m_board = m_prevBoard;
 
-        MiniString<2U> promoStr;
-        if (promo != Piece::NONE)
-        {
-            promoStr.setLength(2U);
-            promoStr[0U] = '=';
-            promoStr[1U] = StringUtils::promoPieceChar(promo);
-        }
-
-        throw PgnError(
-            pgnErrorCode,
-            std::format("{} {}{}{}{}{}{}",
-                        StringUtils::moveNumToString(moveNumOfPly(plyNum), colorOfPly(plyNum)).getStringView(),
-                        StringUtils::pieceToSanStr(piece).getStringView(),
-                        StringUtils::sourceMaskToString(srcMask).getStringView(),
-                        capture ? std::string_view { "x" } : std::string_view { },
-                        StringUtils::colChar(dst),
-                        StringUtils::rowChar(dst),
-                        promoStr.getStringView()));
+        m_pendingError.emplace(pgnErrorCode, PgnErrorMoveInfo { plyNum, piece, srcMask, dst, promo, capture, false });
     }
 
     void badCastlingMove(
@@ -117,18 +125,35 @@ private:
         std::uint32_t plyNum,
         bool shortCastle)
     {
-        throw PgnError(
+        m_pendingError.emplace(
             pgnErrorCode,
-            std::format("{} {}",
-                        StringUtils::moveNumToString(moveNumOfPly(plyNum), colorOfPly(plyNum)).getStringView(),
-                        shortCastle ? "O-O" : "O-O-O"));
+            PgnErrorMoveInfo { plyNum, Piece::KING, SquareSet::none(), Square::NONE, Piece::NONE, false, shortCastle });
+    }
+
+    inline void applyMove(const Move m)
+    {
+        if (isActionClassEnabled<PgnReaderActionClass::Variation>())
+        {
+            m_lastMove.move = m;
+            m_board.doMove(m, m_lastMove.undoInfo);
+
+            if (m_variationLevel != 0U)
+                m_variationMoves.push_back(m_lastMove);
+        }
+        else
+        {
+            m_board.doMove(m);
+        }
+
+        m_actions.afterMove(m);
     }
 
 public:
-    PgnReaderParserActions(PgnReaderActions &actions, PgnReaderActionFilter filter, const PgnScanner &pgnScanner) :
+    PgnReaderParserActions(T_Actions &actions, PgnReaderActionFilter filter, const PgnScanner &pgnScanner) :
         m_actions { actions },
         m_filter { filter },
-        m_pgnScanner { pgnScanner }
+        m_pgnScanner { pgnScanner },
+        m_inputLocation { pgnScanner }
     {
         // nags require move reporting
         if (!m_filter.isEnabled(PgnReaderActionClass::Move))
@@ -143,11 +168,40 @@ public:
         {
             m_actions.setBoardReferences(m_board, m_prevBoard);
         }
+
+        m_actions.setInputLocationReference(m_inputLocation);
+    }
+
+    bool hasPendingError() const noexcept
+    {
+        return m_pendingError.has_value();
+    }
+
+    PgnError &getPendingError() noexcept
+    {
+        return *m_pendingError;
+    }
+
+    void clearPendingError() noexcept
+    {
+        m_pendingError.reset();
     }
 
     void gameStart()
     {
+        m_inputLocation.recordGameStart();
+        m_pendingError.reset();
         m_board.loadStartPos();
+
+        // in case the previous game was aborted by an error
+        m_variationLevel = 0U;
+
+        if (isActionClassEnabled<PgnReaderActionClass::Variation>())
+        {
+            m_lastMove = MoveAndUndoInfo { };
+            m_variationMoves.clear();
+        }
+
         m_actions.gameStart();
     }
 
@@ -166,6 +220,7 @@ public:
 
     void moveTextSection()
     {
+        m_inputLocation.recordMoveTextStart();
         m_actions.moveTextSection();
     }
 
@@ -177,11 +232,7 @@ public:
             {
                 if (moveNumOfPly(m_board.getCurrentPlyNum()) != moveNum)
                 {
-                    throw PgnError(
-                        PgnErrorCode::UNEXPECTED_MOVE_NUM,
-                        std::format("Expected move {} but got {}",
-                                    moveNumOfPly(m_board.getCurrentPlyNum()),
-                                    moveNum));
+                    m_pendingError.emplace(static_cast<std::uint32_t>(moveNumOfPly(m_board.getCurrentPlyNum())), moveNum);
                 }
             }
         }
@@ -207,8 +258,7 @@ public:
                 const Move m { m_board.generateSingleMoveForPawnAndDestNoCapture(srcMask, dst) };
                 if (!m.isIllegal()) [[likely]]
                 {
-                    m_board.doMove(m);
-                    m_actions.afterMove(m);
+                    applyMove(m);
                 }
                 else
                     moveValidationError(m, Piece::PAWN, srcMask, dst, Piece::NONE, false);
@@ -227,8 +277,7 @@ public:
                 const Move m { m_board.generateSingleMoveForPawnAndDestCapture(srcMask, dst) };
                 if (!m.isIllegal()) [[likely]]
                 {
-                    m_board.doMove(m);
-                    m_actions.afterMove(m);
+                    applyMove(m);
                 }
                 else
                     moveValidationError(m, Piece::PAWN, srcMask, dst, Piece::NONE, true);
@@ -247,8 +296,7 @@ public:
                 const Move m { m_board.generateSingleMoveForPawnAndDestPromoNoCapture(srcMask, dst, promo) };
                 if (!m.isIllegal()) [[likely]]
                 {
-                    m_board.doMove(m);
-                    m_actions.afterMove(m);
+                    applyMove(m);
                 }
                 else
                     moveValidationError(m, Piece::PAWN, srcMask, dst, promo, false);
@@ -267,8 +315,7 @@ public:
                 const Move m { m_board.generateSingleMoveForPawnAndDestPromoCapture(srcMask, dst, promo) };
                 if (!m.isIllegal()) [[likely]]
                 {
-                    m_board.doMove(m);
-                    m_actions.afterMove(m);
+                    applyMove(m);
                 }
                 else
                     moveValidationError(m, Piece::PAWN, srcMask, dst, promo, true);
@@ -307,10 +354,10 @@ public:
                         badMove(
                             PgnErrorCode::ILLEGAL_MOVE,
                             m_board.getCurrentPlyNum(), piece, srcMask, dst, Piece::NONE, capture);
+                        return;
                     }
 
-                    m_board.doMove(m);
-                    m_actions.afterMove(m);
+                    applyMove(m);
                 }
                 else
                     moveValidationError(m, piece, srcMask, dst, Piece::NONE, capture);
@@ -355,8 +402,7 @@ public:
 
                 if (!m.isIllegal()) [[likely]]
                 {
-                    m_board.doMove(m);
-                    m_actions.afterMove(m);
+                    applyMove(m);
                 }
                 else
                 {
@@ -378,8 +424,7 @@ public:
 
                 if (!m.isIllegal()) [[likely]]
                 {
-                    m_board.doMove(m);
-                    m_actions.afterMove(m);
+                    applyMove(m);
                 }
                 else
                 {
@@ -404,10 +449,18 @@ public:
     {
         if (isActionClassEnabled<PgnReaderActionClass::Variation>())
         {
-            m_variationParentStack[m_variationLevel].m_board = m_board;
-            m_variationParentStack[m_variationLevel].m_prevBoard = m_prevBoard;
+            VariationParent &parent { m_variationParentStack[m_variationLevel] };
+            parent.lastMove = m_lastMove;
+            parent.numVariationMoves = m_variationMoves.size();
             ++m_variationLevel;
-            m_board = m_prevBoard;
+
+            // the variation replaces the last move. The previous board
+            // already holds the position before the last move, so it stays
+            // valid.
+            if (!m_lastMove.move.isIllegal()) [[likely]]
+                m_board.undoMove(m_lastMove.move, m_lastMove.undoInfo);
+
+            m_lastMove = MoveAndUndoInfo { };
 
             m_actions.variationStart();
         }
@@ -424,8 +477,24 @@ public:
             m_actions.variationEnd();
 
             --m_variationLevel;
-            m_board = m_variationParentStack[m_variationLevel].m_board;
-            m_prevBoard = m_variationParentStack[m_variationLevel].m_prevBoard;
+            const VariationParent &parent { m_variationParentStack[m_variationLevel] };
+
+            // undo the variation moves to return to the variation start
+            // position, and then replay the move that the variation replaced
+            while (m_variationMoves.size() > parent.numVariationMoves)
+            {
+                const MoveAndUndoInfo &variationMove { m_variationMoves.back() };
+                m_board.undoMove(variationMove.move, variationMove.undoInfo);
+                m_variationMoves.pop_back();
+            }
+
+            // setBoardReferences() contract: the previous board is the
+            // position before the last move, so it needs this one copy
+            m_prevBoard = m_board;
+            m_lastMove = parent.lastMove;
+
+            if (!m_lastMove.move.isIllegal()) [[likely]]
+                m_board.doMove(m_lastMove.move);
         }
         else
         {
@@ -435,6 +504,7 @@ public:
 
     void gameTerminated(PgnResult result)
     {
+        m_inputLocation.recordGameEnd();
         m_actions.gameTerminated(result);
     }
 
@@ -456,13 +526,142 @@ public:
 
 };
 
-void skipToNextGame(PgnScanner &pgnScanner)
+namespace
 {
-    // skip tokens until we hit EOF or RESULT
-    while ((pgnScanner.getCurrentToken() != PgnScannerToken::END_OF_FILE) &&
-           (pgnScanner.getCurrentToken() != PgnScannerToken::RESULT))
-        static_cast<void>(pgnScanner.nextTokenNoThrowOnErrorToken());
-}
+
+/// @brief Semantic actions for collecting a game for @coderef{PgnGameReader}
+///
+/// The class is final so that the parser actions can invoke the callbacks
+/// without virtual dispatch.
+class PgnGameCollectorActions final : public PgnReaderActions
+{
+private:
+    struct TagOffsets
+    {
+        std::size_t keyOffset;
+        std::size_t keyLength;
+        std::size_t valueOffset;
+        std::size_t valueLength;
+    };
+
+    struct CommentOffsets
+    {
+        std::size_t moveIndex;
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    const ChessBoard *m_board { };
+    const PgnInputLocation *m_inputLocation { };
+    ChessBoard m_initialBoard { };
+
+    // String data of tags and comments. The views are built once the game
+    // is complete, since appending may reallocate.
+    std::string m_stringData { };
+    std::vector<TagOffsets> m_tagOffsets { };
+    std::vector<CommentOffsets> m_commentOffsets { };
+
+    std::vector<PgnGameTag> m_tags { };
+    std::vector<PgnGameComment> m_comments { };
+    std::vector<Move> m_moves { };
+
+    bool m_inGame { };
+    PgnGameView m_game { };
+
+    std::size_t appendString(std::string_view str)
+    {
+        const std::size_t offset { m_stringData.size() };
+        m_stringData.append(str);
+        return offset;
+    }
+
+public:
+    void setBoardReferences(const ChessBoard &curBoard, const ChessBoard &prevBoard) override
+    {
+        m_board = &curBoard;
+        static_cast<void>(prevBoard);
+    }
+
+    void setInputLocationReference(const PgnInputLocation &location) override
+    {
+        m_inputLocation = &location;
+    }
+
+    void gameStart() override
+    {
+        m_stringData.clear();
+        m_tagOffsets.clear();
+        m_commentOffsets.clear();
+        m_moves.clear();
+        m_inGame = true;
+    }
+
+    void pgnTag(std::string_view key, std::string_view value) override
+    {
+        const std::size_t keyOffset { appendString(key) };
+        const std::size_t valueOffset { appendString(value) };
+
+        m_tagOffsets.push_back(TagOffsets { keyOffset, key.size(), valueOffset, value.size() });
+    }
+
+    void moveTextSection() override
+    {
+        m_initialBoard = *m_board;
+    }
+
+    void comment(std::string_view comment) override
+    {
+        // comments after the last game are not part of any game
+        if (m_inGame)
+        {
+            const std::size_t offset { appendString(comment) };
+            m_commentOffsets.push_back(CommentOffsets { m_moves.size(), offset, comment.size() });
+        }
+    }
+
+    void afterMove(Move move) override
+    {
+        m_moves.push_back(move);
+    }
+
+    void gameTerminated(PgnResult result) override
+    {
+        const char *const data { m_stringData.data() };
+
+        m_tags.clear();
+        for (const TagOffsets &tag : m_tagOffsets)
+        {
+            m_tags.push_back(
+                PgnGameTag {
+                    std::string_view { data + tag.keyOffset, tag.keyLength },
+                    std::string_view { data + tag.valueOffset, tag.valueLength } });
+        }
+
+        m_comments.clear();
+        for (const CommentOffsets &comment : m_commentOffsets)
+        {
+            m_comments.push_back(
+                PgnGameComment {
+                    comment.moveIndex,
+                    std::string_view { data + comment.offset, comment.length } });
+        }
+
+        m_game.tags = m_tags;
+        m_game.initialBoard = &m_initialBoard;
+        m_game.moves = m_moves;
+        m_game.comments = m_comments;
+        m_game.result = result;
+        m_game.inputOffset = m_inputLocation->getGameOffset();
+        m_game.inputLength = m_inputLocation->getGameLength();
+
+        m_inGame = false;
+    }
+
+    const PgnGameView &getGame() const noexcept
+    {
+        return m_game;
+    }
+};
 
 template <typename MinFilter, typename MaxFilter>
 bool tryProcessPgn(std::string_view pgn, PgnReaderActions &actions, PgnReaderActionFilter filter)
@@ -476,40 +675,34 @@ bool tryProcessPgn(std::string_view pgn, PgnReaderActions &actions, PgnReaderAct
     if ((filter.getBitMask() & MaxFilter::getBitMask()) != filter.getBitMask())
         return false;
 
-    PgnScanner pgnScanner { pgn.data(), pgn.size() };
+    using ParserActions = PgnReaderParserActions<MinFilter, MaxFilter>;
 
-    while (true)
-    {
-        try
-        {
-            using ParserActions = PgnReaderParserActions<MinFilter, MaxFilter>;
-            ParserActions readerActions { actions, filter, pgnScanner };
-
-            PgnParser<ParserActions> parser { pgnScanner, readerActions };
-            parser.parse();
+    PgnScanner pgnScanner { pgn.data(), pgn.size() };
+    ParserActions readerActions { actions, filter, pgnScanner };
+    PgnParser<ParserActions> parser { pgnScanner, readerActions };
 
-            // end of input
-            return true;
-        }
-        catch (const PgnError &ex)
+    // Returns false if the error aborts the processing or ends the input.
+    const auto recoverFromError {
+        [&](const PgnError &ex) -> bool
         {
             PgnErrorInfo errorInfo { };
-            errorInfo.lineNumber = pgnScanner.lineno();
+            errorInfo.lineNumber = ex.getLineNumber();
+            errorInfo.byteOffset = ex.getByteOffset();
 
             const PgnReaderOnErrorAction onErrorAction { actions.onError(ex, errorInfo) };
 
             switch (onErrorAction)
             {
                 case PgnReaderOnErrorAction::Abort:
-                    throw;
+                    throw ex;
 
                 case PgnReaderOnErrorAction::ContinueFromNextGame:
-                    skipToNextGame(pgnScanner);
-                    if (pgnScanner.getCurrentToken() == PgnScannerToken::END_OF_FILE)
+                    if (!pgnScanner.skipToNextGame())
                         // end of input
-                        return true;
+                        return false;
 
-                    break;
+                    parser.abortGame();
+                    return true;
 
                 default:
                     throw PgnError(
@@ -517,12 +710,160 @@ bool tryProcessPgn(std::string_view pgn, PgnReaderActions &actions, PgnReaderAct
                         std::format("PgnReader::readFromMemory: Unsupported PgnReaderOnErrorAction {}",
                                     static_cast<unsigned>(onErrorAction)));
             }
+        } };
+
+    while (true)
+    {
+        try
+        {
+            const PgnParserGameResult result { parser.parseGame() };
+
+            if (result == PgnParserGameResult::END_OF_INPUT)
+                return true;
+
+            if (result == PgnParserGameResult::PENDING_ERROR) [[unlikely]]
+            {
+                // move validation error, the parser has already returned
+                const PgnError ex { std::move(readerActions.getPendingError()) };
+                readerActions.clearPendingError();
+
+                if (!recoverFromError(ex))
+                    return true;
+            }
+        }
+        catch (const PgnError &ex)
+        {
+            if (!recoverFromError(ex))
+                return true;
         }
     }
 }
 
 }
 
+void PgnInputLocation::recordGameStart() noexcept
+{
+    m_gameOffset = m_scanner.getTokenStartOffset();
+    m_moveTextOffset = m_gameOffset;
+    m_gameEndOffset = m_gameOffset;
+}
+
+void PgnInputLocation::recordMoveTextStart() noexcept
+{
+    m_moveTextOffset = m_scanner.getTokenStartOffset();
+    m_gameEndOffset = m_moveTextOffset;
+}
+
+void PgnInputLocation::recordGameEnd() noexcept
+{
+    m_gameEndOffset = m_scanner.getTokenEndOffset();
+}
+
+std::uint64_t PgnInputLocation::getTokenOffset() const noexcept
+{
+    return m_scanner.getTokenStartOffset();
+}
+
+std::uint64_t PgnInputLocation::getTokenLength() const noexcept
+{
+    return m_scanner.getTokenEndOffset() - m_scanner.getTokenStartOffset();
+}
+
+/// @brief Implementation of @coderef{PgnGameReader}
+class PgnGameReader::Impl
+{
+private:
+    using Filter = PgnReaderActionCompileTimeFilter<
+        PgnReaderActionClass::PgnTag,
+        PgnReaderActionClass::Move,
+        PgnReaderActionClass::Comment>;
+
+    using ParserActions = PgnReaderParserActions<Filter, Filter, PgnGameCollectorActions>;
+
+    PgnScanner m_scanner;
+    PgnGameCollectorActions m_collector { };
+    ParserActions m_parserActions;
+    PgnParser<ParserActions> m_parser;
+
+    bool m_skipToNextGame { };
+    bool m_endOfInput { };
+
+public:
+    explicit Impl(std::string_view pgn) :
+        m_scanner { pgn.data(), pgn.size() },
+        m_parserActions {
+            m_collector,
+            PgnReaderActionFilter {
+                PgnReaderActionClass::PgnTag,
+                PgnReaderActionClass::Move,
+                PgnReaderActionClass::Comment },
+            m_scanner },
+        m_parser { m_scanner, m_parserActions }
+    {
+    }
+
+    bool nextGame()
+    {
+        if (m_endOfInput)
+            return false;
+
+        if (m_skipToNextGame) [[unlikely]]
+        {
+            m_skipToNextGame = false;
+
+            if (!m_scanner.skipToNextGame())
+            {
+                m_endOfInput = true;
+                return false;
+            }
+
+            m_parser.abortGame();
+        }
+
+        try
+        {
+            const PgnParserGameResult result { m_parser.parseGame() };
+
+            if (result == PgnParserGameResult::PENDING_ERROR) [[unlikely]]
+            {
+                PgnError ex { std::move(m_parserActions.getPendingError()) };
+                m_parserActions.clearPendingError();
+                throw ex;
+            }
+
+            m_endOfInput = (result == PgnParserGameResult::END_OF_INPUT);
+            return !m_endOfInput;
+        }
+        catch (const PgnError &)
+        {
+            m_skipToNextGame = true;
+            throw;
+        }
+    }
+
+    const PgnGameView &getGame() const noexcept
+    {
+        return m_collector.getGame();
+    }
+};
+
+PgnGameReader::PgnGameReader(std::string_view pgn) :
+    m_impl { std::make_unique<Impl>(pgn) }
+{
+}
+
+PgnGameReader::~PgnGameReader() = default;
+
+bool PgnGameReader::nextGame()
+{
+    return m_impl->nextGame();
+}
+
+const PgnGameView &PgnGameReader::getGame() const noexcept
+{
+    return m_impl->getGame();
+}
+
 void PgnReader::readFromMemory(std::string_view pgn, PgnReaderActions &actions, PgnReaderActionFilter filter)
 {
     // select the appropriate compile-time parser+actions combo
@@ -547,4 +888,13 @@ void PgnReader::readFromMemory(std::string_view pgn, PgnReaderActions &actions,
         std::format("Could not find PGN parser for filter bits {}", filter.getBitMask()));
 }
 
+std::size_t PgnReader::findNextGameStart(std::string_view pgn, std::size_t pos) noexcept
+{
+    const char *const inputEnd { pgn.data() + pgn.size() };
+    const char *const gameStart {
+        PgnScanner::findNextGameStart(pgn.data(), pgn.data() + std::min(pos, pgn.size()), inputEnd) };
+
+    return static_cast<std::size_t>(gameStart - pgn.data());
+}
+
 }
@@ -24,7 +24,9 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cinttypes>
+#include <cstdint>
 #include <cstring>
 #include <format>
 #include <string_view>
@@ -39,8 +41,26 @@ namespace hoover_chess_utils::pgn_reader
 class PgnScanner : public ::yyFlexLexer
 {
 private:
+    const char *const m_inputStart;
+    const std::size_t m_inputSize;
     const char *m_inputData;
     std::size_t m_inputLeft;
+
+    /// @brief Input offset of the current token. Updated by
+    /// @c YY_USER_ACTION on every matched rule.
+    std::size_t m_tokenStartOffset { };
+
+    /// @brief Input offset just past the current token. Updated by
+    /// @c YY_USER_ACTION on every matched rule.
+    std::size_t m_tokenEndOffset { };
+
+    /// @brief Input offset up to which line feeds have been counted by
+    /// @coderef{getLineNumber()}
+    mutable std::size_t m_lineCountOffset { };
+
+    /// @brief Number of line feeds before @coderef{m_lineCountOffset}
+    mutable std::uint64_t m_lineCount { };
+
     PgnScannerToken m_curToken { };
     PgnScannerTokenInfo m_tokenInfo;
 
@@ -51,6 +71,8 @@ public:
     /// @param[in]  inputLen      Input length
     PgnScanner(const char *inputData, std::size_t inputLen) noexcept :
         yyFlexLexer { nullptr, nullptr },
+        m_inputStart { inputData },
+        m_inputSize { inputLen },
         m_inputData { inputData },
         m_inputLeft { inputLen },
         m_tokenInfo { }
@@ -119,6 +141,56 @@ public:
         return m_curToken;
     }
 
+    /// @brief Returns the input byte offset of the previously scanned token
+    ///
+    /// @return Byte offset
+    inline std::size_t getTokenStartOffset() const noexcept
+    {
+        return m_tokenStartOffset;
+    }
+
+    /// @brief Returns the input byte offset just past the previously scanned
+    /// token
+    ///
+    /// @return Byte offset
+    inline std::size_t getTokenEndOffset() const noexcept
+    {
+        return m_tokenEndOffset;
+    }
+
+    /// @brief Returns the previously scanned token as a view into the input
+    ///
+    /// @return Token text
+    ///
+    /// Unlike @c YYText(), the returned view stays valid over subsequent
+    /// tokens for as long as the input buffer is valid.
+    inline std::string_view getTokenInputView() const noexcept
+    {
+        return std::string_view { m_inputStart + m_tokenStartOffset, m_tokenEndOffset - m_tokenStartOffset };
+    }
+
+    /// @brief Returns the line number of the previously scanned token
+    ///
+    /// @return Line number. Numbering starts from 1.
+    ///
+    /// The scanner does not track line numbers. Instead, the line feeds are
+    /// counted on demand up to the end of the token. Counting resumes from the
+    /// previous query when the token is not before it, so querying in input
+    /// order takes linear time in total. This is intended for error reporting.
+    std::uint64_t getLineNumber() const noexcept
+    {
+        if (m_tokenEndOffset < m_lineCountOffset) [[unlikely]]
+        {
+            m_lineCountOffset = 0U;
+            m_lineCount = 0U;
+        }
+
+        m_lineCount += countNewlines(m_inputStart + m_lineCountOffset, m_inputStart + m_tokenEndOffset);
+        m_lineCountOffset = m_tokenEndOffset;
+
+        return m_lineCount + 1U;
+    }
+
     /// @brief Returns additional information on the token.
     ///
     /// @return Additional inforation on the current token
@@ -127,6 +199,81 @@ public:
         return m_tokenInfo;
     }
 
+    /// @brief Skips to the next plausible game start. This is intended for
+    /// error recovery.
+    ///
+    /// @return  Whether a game start was found. If not, the scanner is
+    ///          positioned at the end of input and the current token is
+    ///          @c END_OF_FILE.
+    ///
+    /// A plausible game start is a line that begins with @c '[' and is not
+    /// preceded by another line beginning with @c '['. That is, the rest of the
+    /// current tag pair section is skipped, too. The search starts after the
+    /// current token and it uses @c memchr(), so it does not tokenize the
+    /// skipped input.
+    ///
+    /// The scanner state is reset such that the next token is @c TAG_START of
+    /// the game start.
+    bool skipToNextGame();
+
+    /// @brief Finds the next plausible game start.
+    ///
+    /// @param[in] inputStart   Start of input
+    /// @param[in] pos          Search start position
+    /// @param[in] inputEnd     End of input
+    /// @return                 Game start or @p inputEnd if not found
+    ///
+    /// @sa @coderef{skipToNextGame()}
+    static const char *findNextGameStart(const char *inputStart, const char *pos, const char *inputEnd) noexcept
+    {
+        while (true)
+        {
+            const void *const found { std::memchr(pos, '[', static_cast<std::size_t>(inputEnd - pos)) };
+
+            if (found == nullptr)
+                return inputEnd;
+
+            const char *const tagStart { static_cast<const char *>(found) };
+
+            if (isPlausibleGameStart(inputStart, tagStart))
+                return tagStart;
+
+            pos = tagStart + 1U;
+        }
+    }
+
+    /// @brief Counts line feeds in a string
+    ///
+    /// @param[in] begin   Start of string
+    /// @param[in] end     End of string
+    /// @return            Number of @c '\n' characters
+    ///
+    /// The string is processed 8 bytes at a time (SWAR).
+    static std::size_t countNewlines(const char *begin, const char *end) noexcept
+    {
+        constexpr std::uint64_t ctLow7Bits { UINT64_C(0x7F7F7F7F7F7F7F7F) };
+        constexpr std::uint64_t ctLineFeeds { UINT64_C(0x0A0A0A0A0A0A0A0A) };
+
+        std::size_t count { };
+
+        while (end - begin >= 8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, begin, sizeof word);
+
+            // line feeds become zero bytes, which are then flagged in bit 7.
+            // The addition does not carry over byte boundaries, so this is
+            // exact.
+            word ^= ctLineFeeds;
+            const std::uint64_t zeroBytes { ~(((word & ctLow7Bits) + ctLow7Bits) | word | ctLow7Bits) };
+
+            count += static_cast<std::size_t>(std::popcount(zeroBytes));
+            begin += 8U;
+        }
+
+        return count + static_cast<std::size_t>(std::count(begin, end, '\n'));
+    }
+
 #define C(tok) case tok: return #tok
 
     /// @brief Returns a string for a scanner token
@@ -204,6 +351,42 @@ protected:
     }
 
 private:
+    static constexpr bool isNewlineChar(char c) noexcept
+    {
+        return (c == '\n') || (c == '\r');
+    }
+
+    /// @brief Checks whether @p tagStart (a @c '[') starts a line that is not
+    /// preceded by another line that starts with @c '['.
+    ///
+    /// @param[in] inputStart   Start of input
+    /// @param[in] tagStart     Position of @c '['
+    /// @return                 Whether @p tagStart is a plausible game start
+    static bool isPlausibleGameStart(const char *inputStart, const char *tagStart) noexcept
+    {
+        if (tagStart == inputStart)
+            return true;
+
+        // must be at the start of a line
+        const char *p { tagStart - 1U };
+        if (!isNewlineChar(*p))
+            return false;
+
+        // two-character newlines ("\r\n" and "\n\r")
+        if ((p != inputStart) && isNewlineChar(p[-1]) && (p[-1] != *p))
+            --p;
+
+        // empty previous line?
+        if ((p == inputStart) || isNewlineChar(p[-1]))
+            return true;
+
+        // find the start of the previous line
+        while ((p != inputStart) && !isNewlineChar(p[-1]))
+            --p;
+
+        return *p != '[';
+    }
+
     /// @brief The generated lexer
     ///
     /// @return Token
@@ -201,6 +201,122 @@ TEST(ChessBoard, moveTypes)
 }
 
 
+namespace
+{
+
+void expectDoUndoRestoresBoard(ChessBoard &board, std::uint8_t depth)
+{
+    MoveList moves;
+    const std::size_t numMoves { board.generateMoves(moves) };
+
+    for (std::size_t i { }; i < numMoves; ++i)
+    {
+        const ChessBoard refBoard { board };
+        const Move m { moves[i] };
+
+        MoveUndoInfo undoInfo;
+        board.doMove(m, undoInfo);
+
+        ChessBoard doMoveRef { refBoard };
+        doMoveRef.doMove(m);
+        EXPECT_EQ(doMoveRef, board);
+
+        if (depth > 1U)
+            expectDoUndoRestoresBoard(board, depth - 1U);
+
+        board.undoMove(m, undoInfo);
+
+        EXPECT_EQ(refBoard, board);
+        EXPECT_EQ(refBoard.getOccupancyMask(), board.getOccupancyMask());
+        EXPECT_EQ(refBoard.getKingInTurn(), board.getKingInTurn());
+        EXPECT_EQ(refBoard.getKingNotInTurn(), board.getKingNotInTurn());
+        EXPECT_EQ(refBoard.getCheckers(), board.getCheckers());
+        EXPECT_EQ(refBoard.getPinnedPieces(), board.getPinnedPieces());
+        EXPECT_EQ(refBoard.getHalfMoveClock(), board.getHalfMoveClock());
+    }
+}
+
+}
+
+TEST(ChessBoard, undoMove)
+{
+    for (const char *fen : {
+            // start pos
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+
+            // castling, captures, promotions, en passant
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbqkbnr/pp1ppppp/8/4P3/2pP4/8/PPP2PPP/RNBQKBNR b KQkq d3 0 3",
+            "2k1rn2/4P1P1/8/2Pp4/1p1p2p1/P1PP3P/3P4/3K4 w - d6 0 1",
+
+            // Chess960 castling with overlapping squares
+            "1r2k1r1/8/8/8/8/8/8/1R2K1R1 w GBgb - 0 1",
+            "4k3/8/8/8/8/8/8/R4KR1 w GA - 0 1",
+        })
+    {
+        ChessBoard board;
+        board.loadFEN(fen);
+
+        expectDoUndoRestoresBoard(board, 3U);
+    }
+}
+
+namespace
+{
+
+void expectGivesCheckMatchesDoMove(const ChessBoard &board, std::uint8_t depth)
+{
+    MoveList moves;
+    const std::size_t numMoves { board.generateMoves(moves) };
+
+    for (std::size_t i { }; i < numMoves; ++i)
+    {
+        const Move m { moves[i] };
+
+        ChessBoard nextBoard { board };
+        nextBoard.doMove(m);
+
+        EXPECT_EQ(nextBoard.isInCheck(), board.givesCheck(m));
+
+        if (depth > 1U)
+            expectGivesCheckMatchesDoMove(nextBoard, depth - 1U);
+    }
+}
+
+}
+
+TEST(ChessBoard, givesCheck)
+{
+    for (const char *fen : {
+            // start pos
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+
+            // castling, captures, promotions, en passant
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "2k1rn2/4P1P1/8/2Pp4/1p1p2p1/P1PP3P/3P4/3K4 w - d6 0 1",
+
+            // discovered checks by en passant, castling, and promotion
+            "8/8/8/K2pP2q/8/8/8/7k w - d6 0 1",
+            "8/8/8/8/1k1pP2Q/8/8/4K3 b - e3 0 1",
+            "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1",
+            "nkn5/1P6/8/8/8/8/8/1R2K3 w - - 0 1",
+
+            // Chess960 castling with overlapping squares
+            "1r2k1r1/8/8/8/8/8/8/1R2K1R1 w GBgb - 0 1",
+            "4k3/8/8/8/8/8/8/R4KR1 w GA - 0 1",
+        })
+    {
+        ChessBoard board;
+        board.loadFEN(fen);
+
+        expectGivesCheckMatchesDoMove(board, 3U);
+    }
+}
+
 TEST(MoveGenIteratorTraits, basics)
 {
     // MoveList::iterator: no early completion; stores moves (in the list)
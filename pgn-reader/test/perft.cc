@@ -15,12 +15,18 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "chessboard.h"
+#include "pgnreader-error.h"
+#include "pgnreader-string-utils.h"
 
+#include <algorithm>
+#include <atomic>
 #include <charconv>
 #include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <limits>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 namespace
@@ -40,16 +46,23 @@ void printHelp(const char *exe)
         "Performance test for the PGN reader move generator.\n"
         "\n"
         "Usage: %s [options] <depth> [<FEN>]\n"
+        "       %s [options] --suite <suite.epd> [<max-depth>]\n"
         "\n"
-        "  <depth>    Search tree depth.\n"
-        "  <FEN>      FEN of the search root. If omitted, standard starting position is\n"
-        "             used. Shell quoting is not needed.\n"
+        "  <depth>        Search tree depth.\n"
+        "  <FEN>          FEN of the search root. If omitted, standard starting position\n"
+        "                 is used. Shell quoting is not needed.\n"
+        "  <suite.epd>    Perft test suite. Every line contains a FEN followed by\n"
+        "                 expected node counts in format ';D<depth> <nodes>'.\n"
+        "  <max-depth>    Maximum depth to verify in the test suite. Default: all.\n"
         "\n"
         "Options:\n"
-        "-- bulk-moves     Compute perft using move list length at leaf depth\n"
-        "-- leaf-moves     Compute perft producing moves also at leaf depth\n"
-        "-- play-moves     Compute perft producing moves and playing all moves\n"
+        "--bulk-moves     Compute perft using move list length at leaf depth\n"
+        "--leaf-moves     Compute perft producing moves also at leaf depth\n"
+        "--play-moves     Compute perft producing moves and playing all moves\n"
+        "--threads <n>    Number of worker threads for the test suite. Default:\n"
+        "                 hardware concurrency\n"
         "\n",
+        std::filesystem::path(exe).filename().c_str(),
         std::filesystem::path(exe).filename().c_str());
 }
 
@@ -91,13 +104,8 @@ inline std::size_t leafNodes(const ChessBoard &board) noexcept
 
 template <PerftMode mode>
 std::tuple<std::uint64_t, std::chrono::steady_clock::duration>
-perftDepth1(const std::string &fen)
+perftDepth1(const ChessBoard &board)
 {
-    ChessBoard board { };
-
-    if (!fen.empty())
-        board.loadFEN(fen.c_str());
-
     const std::chrono::steady_clock::time_point begin { std::chrono::steady_clock::now() };
     const std::uint64_t numLegalMoves { leafNodes<mode>(board) };
     const std::chrono::steady_clock::time_point end { std::chrono::steady_clock::now() };
@@ -124,14 +132,11 @@ void initializeFrame(Frame &frame)
 
 template <PerftMode mode>
 std::tuple<std::uint64_t, std::chrono::steady_clock::duration>
-perftDepth2(const std::string &fen)
+perftDepth2(const ChessBoard &rootBoard)
 {
     std::uint64_t numPositions { };
 
-    ChessBoard board { };
-
-    if (!fen.empty())
-        board.loadFEN(fen.c_str());
+    ChessBoard board { rootBoard };
 
     const std::chrono::steady_clock::time_point begin { std::chrono::steady_clock::now() };
 
@@ -161,14 +166,13 @@ perftDepth2(const std::string &fen)
 
 template <PerftMode mode>
 std::tuple<std::uint64_t, std::chrono::steady_clock::duration>
-perftDepth3Plus(const std::string &fen, const std::uint_fast8_t maxDepth)
+perftDepth3Plus(const ChessBoard &rootBoard, const std::uint_fast8_t maxDepth)
 {
     std::uint64_t numPositions { };
     std::vector<Frame> stack { };
     stack.resize(maxDepth - 2U);
 
-    if (!fen.empty())
-        stack[0U].board.loadFEN(fen.c_str());
+    stack[0U].board = rootBoard;
 
     const std::chrono::steady_clock::time_point begin { std::chrono::steady_clock::now() };
 
@@ -237,31 +241,27 @@ perftDepth3Plus(const std::string &fen, const std::uint_fast8_t maxDepth)
 }
 
 template <PerftMode mode>
-void perft(const std::string &fen, const std::uint_fast8_t maxDepth)
+std::tuple<std::uint64_t, std::chrono::steady_clock::duration>
+perftNodes(const ChessBoard &board, const std::uint_fast8_t maxDepth)
 {
-    using namespace hoover_chess_utils::pgn_reader;
-
-    std::uint64_t numPositions { };
-    std::chrono::steady_clock::duration duration { };
-
     switch (maxDepth)
     {
         case 0U:
-            break;
+            return std::make_tuple(std::uint64_t { }, std::chrono::steady_clock::duration { });
 
         case 1U:
-            std::tie(numPositions, duration) = perftDepth1<mode>(fen);
-            break;
+            return perftDepth1<mode>(board);
 
         case 2U:
-            std::tie(numPositions, duration) = perftDepth2<mode>(fen);
-            break;
+            return perftDepth2<mode>(board);
 
         default:
-            std::tie(numPositions, duration) = perftDepth3Plus<mode>(fen, maxDepth);
-            break;
+            return perftDepth3Plus<mode>(board, maxDepth);
     }
+}
 
+void printNodesPerSecond(std::uint64_t numPositions, std::chrono::steady_clock::duration duration)
+{
     const std::int64_t usecs { std::chrono::duration_cast<std::chrono::microseconds>(duration).count() };
     printf("Searched %" PRIu64 " positions in %" PRId64 ".%06" PRId64 " seconds\n",
            numPositions, usecs / 1000000, std::abs(usecs % 1000000));
@@ -271,6 +271,234 @@ void perft(const std::string &fen, const std::uint_fast8_t maxDepth)
     }
 }
 
+template <PerftMode mode>
+void perft(const std::string &fen, const std::uint_fast8_t maxDepth)
+{
+    ChessBoard board { };
+
+    if (!fen.empty())
+        board.loadFEN(fen.c_str());
+
+    const auto [ numPositions, duration ] { perftNodes<mode>(board, maxDepth) };
+
+    printNodesPerSecond(numPositions, duration);
+}
+
+struct SuitePosition
+{
+    std::size_t lineNumber;
+    std::string fen;
+    ChessBoard board;
+};
+
+struct SuiteJob
+{
+    std::size_t positionIndex;
+    std::uint8_t depth;
+    std::uint64_t expectedNodes;
+    std::uint64_t nodes;
+};
+
+// Parses a perft suite in EPD format. Example line:
+//
+//   4k3/8/8/8/8/8/8/4K2R w K - 0 1 ;D1 15 ;D2 66 ;D3 1197
+//
+// Depths above maxDepth are skipped.
+bool loadSuite(
+    const char *suiteFile, std::uint8_t maxDepth,
+    std::vector<SuitePosition> &positions, std::vector<SuiteJob> &jobs)
+{
+    std::ifstream in { suiteFile };
+
+    if (!in)
+    {
+        fprintf(stderr, "Failed to open '%s'\n", suiteFile);
+        return false;
+    }
+
+    std::string line { };
+    std::size_t lineNumber { };
+
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+
+        std::string_view tokens { line };
+        const std::size_t fenEnd { std::min(tokens.find(';'), tokens.size()) };
+        std::string_view fen { tokens.substr(0U, fenEnd) };
+
+        while (!fen.empty() && fen.back() <= ' ')
+            fen.remove_suffix(1U);
+
+        if (fen.empty())
+            continue;
+
+        SuitePosition &position { positions.emplace_back(lineNumber, std::string { fen }, ChessBoard { }) };
+
+        try
+        {
+            position.board.loadFEN(position.fen);
+        }
+        catch (const PgnError &ex)
+        {
+            fprintf(stderr, "%s:%zu: Bad FEN '%s': %s\n", suiteFile, lineNumber, position.fen.c_str(), ex.what());
+            return false;
+        }
+
+        // depth specs
+        tokens.remove_prefix(fenEnd);
+        while (!tokens.empty())
+        {
+            tokens.remove_prefix(1U); // ';'
+
+            const std::size_t specEnd { std::min(tokens.find(';'), tokens.size()) };
+            const std::string_view spec { tokens.substr(0U, specEnd) };
+            tokens.remove_prefix(specEnd);
+
+            const char *i { spec.data() };
+            const char *const end { spec.data() + spec.size() };
+
+            while (i != end && *i == ' ')
+                ++i;
+
+            std::uint8_t depth { };
+            std::uint64_t expectedNodes { };
+            std::from_chars_result res { };
+
+            if (i == end || *i != 'D')
+                continue;
+
+            res = std::from_chars(i + 1U, end, depth);
+            if (res.ec != std::errc { } || res.ptr == end || *res.ptr != ' ')
+            {
+                fprintf(stderr, "%s:%zu: Bad depth spec '%.*s'\n",
+                        suiteFile, lineNumber, static_cast<int>(spec.size()), spec.data());
+                return false;
+            }
+
+            res = std::from_chars(res.ptr + 1U, end, expectedNodes);
+            if (res.ec != std::errc { })
+            {
+                fprintf(stderr, "%s:%zu: Bad depth spec '%.*s'\n",
+                        suiteFile, lineNumber, static_cast<int>(spec.size()), spec.data());
+                return false;
+            }
+
+            if (depth <= maxDepth)
+                jobs.emplace_back(positions.size() - 1U, depth, expectedNodes, 0U);
+        }
+    }
+
+    return true;
+}
+
+template <PerftMode mode>
+void printDivide(const ChessBoard &board, std::uint8_t depth)
+{
+    MoveList moves;
+    const std::size_t numMoves { board.generateMoves(moves) };
+
+    for (std::size_t i { }; i < numMoves; ++i)
+    {
+        ChessBoard child { board };
+        child.doMove(moves[i]);
+
+        const std::uint64_t nodes {
+            depth >= 2U ? std::get<0U>(perftNodes<mode>(child, depth - 1U)) : 1U };
+
+        const MiniString<7U> san { StringUtils::moveToSan(board, moves[i]) };
+        printf("  %.*s: %" PRIu64 "\n",
+               static_cast<int>(san.size()), san.data(), nodes);
+    }
+}
+
+// Runs all position-depth jobs of a perft suite in a thread pool. The jobs are
+// handed out largest first to keep the workers busy until the end.
+template <PerftMode mode>
+int runSuite(const char *suiteFile, std::uint8_t maxDepth, std::size_t numThreads)
+{
+    std::vector<SuitePosition> positions { };
+    std::vector<SuiteJob> jobs { };
+
+    if (!loadSuite(suiteFile, maxDepth, positions, jobs))
+        return 2;
+
+    std::vector<SuiteJob *> schedule { };
+    schedule.reserve(jobs.size());
+    for (SuiteJob &job : jobs)
+        schedule.push_back(&job);
+
+    std::stable_sort(
+        schedule.begin(), schedule.end(),
+        [] (const SuiteJob *lhs, const SuiteJob *rhs) noexcept
+        {
+            return lhs->expectedNodes > rhs->expectedNodes;
+        });
+
+    numThreads = std::max<std::size_t>(std::min(numThreads, schedule.size()), 1U);
+
+    printf("Running %zu perfts for %zu positions using %zu threads...\n",
+           jobs.size(), positions.size(), numThreads);
+
+    std::atomic<std::size_t> nextJob { };
+
+    const std::chrono::steady_clock::time_point begin { std::chrono::steady_clock::now() };
+
+    {
+        std::vector<std::jthread> threads { };
+
+        for (std::size_t t { }; t < numThreads; ++t)
+        {
+            threads.emplace_back(
+                [&positions, &schedule, &nextJob] ()
+                {
+                    while (true)
+                    {
+                        const std::size_t jobIndex { nextJob.fetch_add(1U, std::memory_order_relaxed) };
+
+                        if (jobIndex >= schedule.size())
+                            break;
+
+                        SuiteJob &job { *schedule[jobIndex] };
+                        job.nodes = std::get<0U>(perftNodes<mode>(positions[job.positionIndex].board, job.depth));
+                    }
+                });
+        }
+    }
+
+    const std::chrono::steady_clock::time_point end { std::chrono::steady_clock::now() };
+
+    std::uint64_t totalNodes { };
+    std::size_t numMismatches { };
+
+    for (const SuiteJob &job : jobs)
+    {
+        totalNodes += job.nodes;
+
+        if (job.nodes != job.expectedNodes) [[unlikely]]
+        {
+            const SuitePosition &position { positions[job.positionIndex] };
+
+            ++numMismatches;
+            printf("[%zu] Perft MISMATCH: FEN=\"%s\" depth=%u expect=%" PRIu64 " perft=%" PRIu64 "\n",
+                   position.lineNumber, position.fen.c_str(), static_cast<unsigned>(job.depth),
+                   job.expectedNodes, job.nodes);
+            printDivide<mode>(position.board, job.depth);
+        }
+    }
+
+    printNodesPerSecond(totalNodes, end - begin);
+
+    if (numMismatches != 0U)
+    {
+        printf("Errors: %zu/%zu perfts mismatched\n", numMismatches, jobs.size());
+        return 2;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
+
 }
 
 
@@ -291,6 +519,8 @@ int main(int argc, char **argv)
     std::uint8_t depth { std::numeric_limits<std::uint8_t>::max() };
     std::string fen { };
     PerftMode perftMode { PerftMode::BULK_MOVES };
+    const char *suiteFile { };
+    std::size_t numThreads { std::max(std::thread::hardware_concurrency(), 1U) };
 
     // parse arguments
     while (argc > 0)
@@ -314,6 +544,28 @@ int main(int argc, char **argv)
         {
             perftMode = PerftMode::PLAY_MOVES;
         }
+        else if (arg == std::string_view { "--threads" } && argc >= 2)
+        {
+            const std::string_view threadsArg { argv[1] };
+            const std::from_chars_result res {
+                std::from_chars(threadsArg.data(), threadsArg.data() + threadsArg.size(), numThreads) };
+
+            if (res.ec != std::errc { } || numThreads == 0U)
+            {
+                fprintf(stderr, "Bad number of threads: '%s'. Try '--help'.\n", argv[1]);
+                return 2;
+            }
+
+            --argc;
+            ++argv;
+        }
+        else if (arg == std::string_view { "--suite" } && argc >= 2)
+        {
+            suiteFile = argv[1];
+
+            --argc;
+            ++argv;
+        }
         else
         {
             break;
@@ -324,6 +576,35 @@ int main(int argc, char **argv)
         ++argv;
     }
 
+    if (suiteFile != nullptr)
+    {
+        if (argc >= 1)
+        {
+            const std::string_view arg { argv[0] };
+            std::from_chars(
+                arg.data(), arg.data() + arg.size(),
+                depth);
+
+            if (depth == std::numeric_limits<std::uint8_t>::max())
+            {
+                fprintf(stderr, "Bad max depth: '%s'. Try '--help'.\n", argv[0]);
+                return 2;
+            }
+        }
+
+        switch (perftMode)
+        {
+            case PerftMode::BULK_MOVES:
+                return runSuite<PerftMode::BULK_MOVES>(suiteFile, depth, numThreads);
+
+            case PerftMode::LEAF_MOVES:
+                return runSuite<PerftMode::LEAF_MOVES>(suiteFile, depth, numThreads);
+
+            case PerftMode::PLAY_MOVES:
+                return runSuite<PerftMode::PLAY_MOVES>(suiteFile, depth, numThreads);
+        }
+    }
+
     if (argc == 0)
     {
         printHelp(exeName);
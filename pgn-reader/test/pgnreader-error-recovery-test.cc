@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <iostream>
 #include <string_view>
+#include <vector>
 
 
 namespace hoover_chess_utils::pgn_reader::unit_test
@@ -200,6 +201,10 @@ public:
     std::uint32_t m_nags { };
     std::uint32_t m_gameEnds { };
     std::uint32_t m_errors { };
+    std::vector<std::uint64_t> m_errorLineNumbers { };
+    std::vector<std::uint64_t> m_errorByteOffsets { };
+    std::vector<PgnErrorCode> m_errorCodes { };
+    std::vector<PgnErrorMoveInfo> m_errorMoves { };
 
     void gameStart() override
     {
@@ -271,6 +276,12 @@ public:
         std::cout << "ContinuingErrorHandlerActions::onError()" << std::endl;
 
         ++m_errors;
+        m_errorLineNumbers.push_back(additionalInfo.lineNumber);
+        m_errorByteOffsets.push_back(additionalInfo.byteOffset);
+        m_errorCodes.push_back(error.getCode());
+
+        if (error.getMoveInfo() != nullptr)
+            m_errorMoves.push_back(*error.getMoveInfo());
 
         return PgnReaderOnErrorAction::ContinueFromNextGame;
     }
@@ -353,6 +364,43 @@ TEST(PgnReader, ErrorRecoveryPolicy_ContinueFromNextGame_EOF)
     EXPECT_EQ(actions.m_gameEnds, 0U);
 }
 
+TEST(PgnReader, ErrorRecoveryPolicy_ContinueFromNextGame_TagSection)
+{
+    // error in the tag pair section skips the rest of the game
+    constexpr std::string_view testPgn {
+        "[Event \"1\"]\n"
+        "[Broken \"value\n"
+        "[Site \"x\"]\n"
+        "\n"
+        "1. e4 e5 *\n"
+        "\n"
+        "[Event \"2\"]\n"
+        "1. e4 e4 *\n"
+        "[Event \"3\"]\n"
+        "1. d4 d5\n"
+        "2. c4 *\n"
+    };
+
+    ContinuingErrorHandlerActions actions { };
+
+    EXPECT_NO_THROW(
+        PgnReader::readFromMemory(
+            testPgn,
+            actions,
+            PgnReaderActionFilter {
+                PgnReaderActionClass::PgnTag,
+                PgnReaderActionClass::Move }));
+
+    EXPECT_EQ(actions.m_errors, 2U);
+    EXPECT_EQ(actions.m_errorLineNumbers, (std::vector<std::uint64_t> { 2U, 8U }));
+
+    EXPECT_EQ(actions.m_gameStarts, 3U);
+    EXPECT_EQ(actions.m_moveTextSections, 2U);
+    EXPECT_EQ(actions.m_pgnTags, 3U);
+    EXPECT_EQ(actions.m_moves, 4U);
+    EXPECT_EQ(actions.m_gameEnds, 1U);
+}
+
 namespace
 {
 
@@ -370,6 +418,41 @@ public:
 
 }
 
+TEST(PgnReader, ErrorRecoveryPolicy_ContinueFromNextGame_StructuredInfo)
+{
+    constexpr std::string_view testPgn {
+        "[TestTag \"TestValue\"]\n"
+        "1. e4 e5 2. Ke3 *\n"
+        "\n"
+        "[TestTag \"TestValue\"]\n"
+        "1. e4 e5 3. Nf3 *\n"
+    };
+
+    ContinuingErrorHandlerActions actions { };
+
+    EXPECT_NO_THROW(
+        PgnReader::readFromMemory(
+            testPgn,
+            actions,
+            PgnReaderActionFilter { PgnReaderActionClass::Move }));
+
+    EXPECT_EQ(actions.m_errors, 2U);
+    EXPECT_EQ(actions.m_errorLineNumbers, (std::vector<std::uint64_t> { 2U, 5U }));
+    EXPECT_EQ(
+        actions.m_errorByteOffsets,
+        (std::vector<std::uint64_t> { testPgn.find("Ke3"), testPgn.find("3. Nf3") }));
+    EXPECT_EQ(
+        actions.m_errorCodes,
+        (std::vector<PgnErrorCode> { PgnErrorCode::ILLEGAL_MOVE, PgnErrorCode::UNEXPECTED_MOVE_NUM }));
+
+    ASSERT_EQ(actions.m_errorMoves.size(), 1U);
+    EXPECT_EQ(actions.m_errorMoves[0U].plyNum, 2U);
+    EXPECT_EQ(actions.m_errorMoves[0U].piece, Piece::KING);
+    EXPECT_EQ(actions.m_errorMoves[0U].dst, Square::E3);
+    EXPECT_EQ(actions.m_errorMoves[0U].promo, Piece::NONE);
+    EXPECT_FALSE(actions.m_errorMoves[0U].capture);
+}
+
 TEST(PgnReader, ErrorRecoveryPolicy_ContinueFromNextGame_BadPolicy)
 {
     // trivially broken
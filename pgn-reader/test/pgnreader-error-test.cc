@@ -18,6 +18,8 @@
 
 #include "gtest/gtest.h"
 
+#include <string_view>
+
 
 namespace hoover_chess_utils::pgn_reader::unit_test
 {
@@ -59,4 +61,71 @@ TEST(PgnError, getStringForCode)
     }
 }
 
+TEST(PgnError, textMessage)
+{
+    PgnError err { PgnErrorCode::BAD_FEN, "Test details" };
+
+    EXPECT_EQ(err.getCode(), PgnErrorCode::BAD_FEN);
+    EXPECT_EQ(err.getMoveInfo(), nullptr);
+    EXPECT_EQ(err.getLineNumber(), 0U);
+    EXPECT_EQ(std::string_view { err.what() }, "Error 5 (Bad FEN): Test details");
+
+    // the message is re-formatted after the location is set
+    err.setLocation(12U, 345U);
+    EXPECT_EQ(err.getLineNumber(), 12U);
+    EXPECT_EQ(err.getByteOffset(), 345U);
+    EXPECT_EQ(std::string_view { err.what() }, "Line 12: Error 5 (Bad FEN): Test details");
+}
+
+TEST(PgnError, moveMessage)
+{
+    const PgnError err {
+        PgnErrorCode::ILLEGAL_MOVE,
+        PgnErrorMoveInfo {
+            3U, Piece::KNIGHT, SquareSet::column(1U), Square::D7, Piece::NONE, true, false } };
+
+    EXPECT_EQ(err.getCode(), PgnErrorCode::ILLEGAL_MOVE);
+    ASSERT_NE(err.getMoveInfo(), nullptr);
+    EXPECT_EQ(err.getMoveInfo()->plyNum, 3U);
+    EXPECT_EQ(err.getMoveInfo()->piece, Piece::KNIGHT);
+    EXPECT_EQ(err.getMoveInfo()->srcMask, SquareSet::column(1U));
+    EXPECT_EQ(err.getMoveInfo()->dst, Square::D7);
+    EXPECT_EQ(err.getMoveInfo()->promo, Piece::NONE);
+    EXPECT_TRUE(err.getMoveInfo()->capture);
+    EXPECT_EQ(std::string_view { err.what() }, "Error 6 (Illegal move): 2... Nbxd7");
+
+    const PgnError promoErr {
+        PgnErrorCode::AMBIGUOUS_MOVE,
+        PgnErrorMoveInfo {
+            0U, Piece::PAWN, SquareSet::all(), Square::A8, Piece::QUEEN, false, false } };
+
+    EXPECT_EQ(std::string_view { promoErr.what() }, "Error 7 (Ambiguous move): 1. a8=Q");
+}
+
+TEST(PgnError, castlingMoveMessage)
+{
+    const PgnError shortErr {
+        PgnErrorCode::ILLEGAL_MOVE,
+        PgnErrorMoveInfo {
+            0U, Piece::KING, SquareSet::none(), Square::NONE, Piece::NONE, false, true } };
+
+    EXPECT_EQ(std::string_view { shortErr.what() }, "Error 6 (Illegal move): 1. O-O");
+
+    const PgnError longErr {
+        PgnErrorCode::ILLEGAL_MOVE,
+        PgnErrorMoveInfo {
+            1U, Piece::KING, SquareSet::none(), Square::NONE, Piece::NONE, false, false } };
+
+    EXPECT_EQ(std::string_view { longErr.what() }, "Error 6 (Illegal move): 1... O-O-O");
+}
+
+TEST(PgnError, moveNumMessage)
+{
+    const PgnError err { 3U, 5U };
+
+    EXPECT_EQ(err.getCode(), PgnErrorCode::UNEXPECTED_MOVE_NUM);
+    EXPECT_EQ(err.getMoveInfo(), nullptr);
+    EXPECT_EQ(std::string_view { err.what() }, "Error 3 (Unexpected move number): Expected move 3 but got 5");
+}
+
 }
@@ -0,0 +1,198 @@
+// Hoover Chess Utilities / PGN reader
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "chessboard.h"
+#include "pgnreader.h"
+#include "pgnreader-error.h"
+#include "pgnreader-string-utils.h"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace hoover_chess_utils::pgn_reader::unit_test
+{
+
+namespace
+{
+
+std::vector<std::string> movesToSan(const PgnGameView &game)
+{
+    std::vector<std::string> ret { };
+    ChessBoard board { *game.initialBoard };
+
+    for (Move m : game.moves)
+        ret.push_back(std::string { StringUtils::moveToSanAndPlay(board, m).getStringView() });
+
+    return ret;
+}
+
+}
+
+TEST(PgnGameReader, basic)
+{
+    constexpr std::string_view testPgn {
+        "{ pre-tag comment } [Event \"Test \\\"1\\\"\"]\n"
+        "[Site \"Here\"]\n"
+        "\n"
+        "{ start } 1. e4 e5 { after e5 } 2. Nf3 (2. d4 { not reported }) 2... Nc6 $1 1-0\n"
+        "\n"
+        "[FEN \"5k2/8/8/8/8/8/8/4K2R w K - 0 40\"]\n"
+        "\n"
+        "40. O-O+ Ke7 1/2-1/2\n"
+        "; trailing comment\n"
+    };
+
+    PgnGameReader reader { testPgn };
+
+    ASSERT_TRUE(reader.nextGame());
+    {
+        const PgnGameView &game { reader.getGame() };
+
+        ASSERT_EQ(game.tags.size(), 2U);
+        EXPECT_EQ(game.tags[0U].key, "Event");
+        EXPECT_EQ(game.tags[0U].value, "Test \"1\"");
+        EXPECT_EQ(game.tags[1U].key, "Site");
+        EXPECT_EQ(game.tags[1U].value, "Here");
+
+        EXPECT_EQ(game.initialBoard->getCurrentPlyNum(), 0U);
+        EXPECT_EQ(movesToSan(game), (std::vector<std::string> { "e4", "e5", "Nf3", "Nc6" }));
+
+        ASSERT_EQ(game.comments.size(), 3U);
+        EXPECT_EQ(game.comments[0U].moveIndex, 0U);
+        EXPECT_EQ(game.comments[0U].text, "pre-tag comment");
+        EXPECT_EQ(game.comments[1U].moveIndex, 0U);
+        EXPECT_EQ(game.comments[1U].text, "start");
+        EXPECT_EQ(game.comments[2U].moveIndex, 2U);
+        EXPECT_EQ(game.comments[2U].text, "after e5");
+
+        EXPECT_EQ(game.result, PgnResult::WHITE_WIN);
+    }
+
+    ASSERT_TRUE(reader.nextGame());
+    {
+        const PgnGameView &game { reader.getGame() };
+
+        ASSERT_EQ(game.tags.size(), 1U);
+        EXPECT_EQ(game.tags[0U].key, "FEN");
+
+        EXPECT_EQ(game.initialBoard->getCurrentPlyNum(), 78U);
+        EXPECT_EQ(movesToSan(game), (std::vector<std::string> { "O-O+", "Ke7" }));
+        EXPECT_TRUE(game.comments.empty());
+        EXPECT_EQ(game.result, PgnResult::DRAW);
+    }
+
+    EXPECT_FALSE(reader.nextGame());
+    EXPECT_FALSE(reader.nextGame());
+}
+
+TEST(PgnGameReader, iterator)
+{
+    constexpr std::string_view testPgn {
+        "1. e4 *\n"
+        "1. d4 d5 0-1\n"
+        "*\n"
+    };
+
+    PgnGameReader reader { testPgn };
+    std::vector<std::size_t> numMoves { };
+    std::vector<PgnResult> results { };
+
+    for (const PgnGameView &game : reader)
+    {
+        numMoves.push_back(game.moves.size());
+        results.push_back(game.result);
+    }
+
+    EXPECT_EQ(numMoves, (std::vector<std::size_t> { 1U, 2U, 0U }));
+    EXPECT_EQ(results, (std::vector<PgnResult> { PgnResult::UNKNOWN, PgnResult::BLACK_WIN, PgnResult::UNKNOWN }));
+}
+
+TEST(PgnGameReader, inputLocation)
+{
+    constexpr std::string_view testPgn {
+        "[Event \"Test\"]\n"
+        "\n"
+        "1. e4 *\n"
+        "\n"
+        "1. d4 d5 0-1\n"
+    };
+
+    PgnGameReader reader { testPgn };
+    std::vector<std::string_view> games { };
+
+    for (const PgnGameView &game : reader)
+        games.push_back(testPgn.substr(game.inputOffset, game.inputLength));
+
+    EXPECT_EQ(games, (std::vector<std::string_view> { "[Event \"Test\"]\n\n1. e4 *", "1. d4 d5 0-1" }));
+}
+
+TEST(PgnGameReader, emptyInput)
+{
+    PgnGameReader reader { "; just a comment\n" };
+
+    EXPECT_FALSE(reader.nextGame());
+    EXPECT_TRUE(reader.begin() == reader.end());
+}
+
+TEST(PgnGameReader, errorRecovery)
+{
+    constexpr std::string_view testPgn {
+        "[Event \"Game 1\"]\n"
+        "1. e4 e5 *\n"
+        "[Event \"Game 2\"]\n"
+        "1. e4 e4 *\n"
+        "[Event \"Game 3\"]\n"
+        "1. d4 *\n"
+    };
+
+    PgnGameReader reader { testPgn };
+
+    ASSERT_TRUE(reader.nextGame());
+    EXPECT_EQ(reader.getGame().tags[0U].value, "Game 1");
+    EXPECT_EQ(reader.getGame().moves.size(), 2U);
+
+    try
+    {
+        static_cast<void>(reader.nextGame());
+        FAIL() << "Expected PgnError";
+    }
+    catch (const PgnError &ex)
+    {
+        EXPECT_EQ(ex.getCode(), PgnErrorCode::ILLEGAL_MOVE);
+    }
+
+    ASSERT_TRUE(reader.nextGame());
+    EXPECT_EQ(reader.getGame().tags[0U].value, "Game 3");
+    EXPECT_EQ(reader.getGame().moves.size(), 1U);
+
+    EXPECT_FALSE(reader.nextGame());
+}
+
+TEST(PgnGameReader, errorAtLastGame)
+{
+    PgnGameReader reader { "1. e5 *\n" };
+
+    EXPECT_THROW(static_cast<void>(reader.nextGame()), PgnError);
+    EXPECT_FALSE(reader.nextGame());
+}
+
+}
@@ -25,6 +25,7 @@
 #include <cstring>
 #include <regex>
 #include <string_view>
+#include <vector>
 
 namespace hoover_chess_utils::pgn_reader::unit_test
 {
@@ -495,6 +496,24 @@ TEST(PgnReader, pgnTagPairEscape)
     EXPECT_EQ(actions.tagValues.at(0), "TestTagValue\"");
 }
 
+TEST(PgnReader, pgnTagPairEscapeMixed)
+{
+    std::string_view pgn {
+        "[A \"\"]\n"
+        "[B \"plain value\"]\n"
+        "[C \"\\\\start\"]\n"
+        "[D \"mid\\\"dle\\\\\"]\n"
+        "[E \"after escapes\"]\n"
+        "*\n"
+    };
+
+    PgnTagCollectorActions actions { };
+    PgnReader::readFromMemory(pgn, actions, PgnReaderActionFilter { PgnReaderActionClass::PgnTag });
+
+    EXPECT_EQ(actions.tagKeys, (std::vector<std::string> { "A", "B", "C", "D", "E" }));
+    EXPECT_EQ(actions.tagValues, (std::vector<std::string> { "", "plain value", "\\start", "mid\"dle\\", "after escapes" }));
+}
+
 TEST(PgnReader, filters_unsupportedActionClass)
 {
     std::string_view pgn { "*\n" };
@@ -1163,6 +1182,8 @@ TEST(PgnReader, comments)
     testComment("{     12   \n     3      }", "12\n     3");
     testComment("{     12   \n\n 1\t\n     3      }", "12\n\n 1\n     3");
     testComment("{\v\t     12   \n\n 1\t\n     3      }", "12\n\n 1\n     3");
+    testComment("{\n\n 12\r\n3 }", " 12\n3");
+    testComment("{ 12 }", "12");
 }
 
 namespace
@@ -1400,6 +1421,98 @@ TEST(PgnReader, startMoveCommentAndMoveTextOrdering)
         PgnReaderActionFilter { PgnReaderActionClass::Comment });
 }
 
+namespace
+{
+class InputLocationCollectorActions : public PgnReaderActions
+{
+private:
+    const PgnInputLocation *m_location { };
+
+public:
+    std::vector<std::string_view> m_games { };
+    std::vector<std::string_view> m_tagSections { };
+    std::vector<std::string_view> m_moveTexts { };
+    std::vector<std::string_view> m_moveTokens { };
+    std::string_view m_pgn { };
+
+    void setInputLocationReference(const PgnInputLocation &location) override
+    {
+        m_location = &location;
+    }
+
+    void afterMove([[maybe_unused]] Move move) override
+    {
+        m_moveTokens.push_back(m_pgn.substr(m_location->getTokenOffset(), m_location->getTokenLength()));
+    }
+
+    void gameTerminated([[maybe_unused]] PgnResult result) override
+    {
+        m_games.push_back(m_pgn.substr(m_location->getGameOffset(), m_location->getGameLength()));
+        m_tagSections.push_back(m_pgn.substr(m_location->getGameOffset(), m_location->getTagSectionLength()));
+        m_moveTexts.push_back(m_pgn.substr(m_location->getMoveTextOffset(), m_location->getMoveTextLength()));
+    }
+};
+}
+
+TEST(PgnReader, inputLocation)
+{
+    std::string_view pgn {
+        "{ Leading comment }\n"
+        "[Tag \"Key\"]\n"
+        "[Tag2 \"Key2\"]\n"
+        "\n"
+        "1. e4 { Comment } e5 2. Nf3 1-0\n"
+        "\n"
+        "1. d4 *\n"
+    };
+
+    InputLocationCollectorActions actions { };
+    actions.m_pgn = pgn;
+
+    PgnReader::readFromMemory(
+        pgn, actions,
+        PgnReaderActionFilter { PgnReaderActionClass::PgnTag, PgnReaderActionClass::Move });
+
+    EXPECT_EQ(
+        actions.m_games,
+        (std::vector<std::string_view> {
+            "[Tag \"Key\"]\n[Tag2 \"Key2\"]\n\n1. e4 { Comment } e5 2. Nf3 1-0",
+            "1. d4 *" }));
+
+    EXPECT_EQ(
+        actions.m_tagSections,
+        (std::vector<std::string_view> { "[Tag \"Key\"]\n[Tag2 \"Key2\"]\n\n", "" }));
+
+    EXPECT_EQ(
+        actions.m_moveTexts,
+        (std::vector<std::string_view> { "1. e4 { Comment } e5 2. Nf3 1-0", "1. d4 *" }));
+
+    EXPECT_EQ(
+        actions.m_moveTokens,
+        (std::vector<std::string_view> { "e4", "e5", "Nf3", "d4" }));
+}
+
+TEST(PgnReader, findNextGameStart)
+{
+    constexpr std::string_view pgn {
+        "[Event \"x\"]\r\n"
+        "[Site \"y\"]\r\n"
+        "\r\n"
+        "1. e4 *\r\n"
+        "\r\n"
+        "[Event \"z\"]\r\n"
+        "1. d4 *\r\n"
+    };
+
+    EXPECT_EQ(PgnReader::findNextGameStart(pgn, 0U), 0U);
+    EXPECT_EQ(PgnReader::findNextGameStart(pgn, 1U), pgn.find("[Event \"z\"]"));
+    EXPECT_EQ(PgnReader::findNextGameStart(pgn, pgn.find("[Event \"z\"]") + 1U), pgn.size());
+
+    // search start past the end
+    EXPECT_EQ(PgnReader::findNextGameStart(pgn, pgn.size() + 1U), pgn.size());
+    EXPECT_EQ(PgnReader::findNextGameStart(std::string_view { }, 0U), 0U);
+}
+
 TEST(PgnReaderActionFilter, sanity)
 {
     PgnReaderActionFilter filter { };
@@ -22,8 +22,10 @@
 #include "include/pgnreader-string-utils.h"
 #include "src/pgnscanner.h"
 
+#include <algorithm>
 #include <format>
 #include <iostream>
+#include <string>
 #include <string_view>
 
 extern unsigned char scannertest_1_pgn_data[];
@@ -270,6 +272,138 @@ TEST(PgnScannerTest, malformedTokens)
     }
 }
 
+TEST(PgnScannerTest, findNextGameStart)
+{
+    auto findFrom = [] (std::string_view input, std::size_t pos) -> std::size_t
+    {
+        const char *const gameStart {
+            PgnScanner::findNextGameStart(input.data(), input.data() + pos, input.data() + input.size()) };
+        return static_cast<std::size_t>(gameStart - input.data());
+    };
+
+    // game starts after movetext, after an empty line, and at input start
+    EXPECT_EQ(findFrom("1. e4 *\n[Event \"x\"]\n", 0U), 8U);
+    EXPECT_EQ(findFrom("1. e4 *\n\n[Event \"x\"]\n", 0U), 9U);
+    EXPECT_EQ(findFrom("1. e4 *\r\n\r\n[Event \"x\"]\r\n", 0U), 11U);
+    EXPECT_EQ(findFrom("[Event \"x\"]\n", 0U), 0U);
+
+    // CR line endings
+    EXPECT_EQ(findFrom("1. e4 *\r[Event \"x\"]\r", 0U), 8U);
+
+    // not at the start of a line
+    EXPECT_EQ(findFrom("1. e4 {[%clk 0:01:00]} *\n", 0U), 25U);
+
+    // remaining tag pairs of the current game are skipped
+    EXPECT_EQ(findFrom("[Event \"x\"]\n[Site \"y\"]\n\n1. e4 *\n\n[Event \"z\"]\n", 1U), 33U);
+    EXPECT_EQ(findFrom("[Event \"x\"]\r\n[Site \"y\"]\r\n1. e4 *\r\n[Event \"z\"]\r\n", 1U), 34U);
+
+    // but an empty line separates games
+    EXPECT_EQ(findFrom("[Event \"x\"]\n\n[Event \"y\"]\n", 1U), 13U);
+
+    // not found
+    EXPECT_EQ(findFrom("", 0U), 0U);
+    EXPECT_EQ(findFrom("1. e4 *\n", 0U), 8U);
+}
+
+TEST(PgnScannerTest, skipToNextGame)
+{
+    constexpr std::string_view input {
+        "[Event \"x\"]\n"
+        "[Site \"y\"]\n"
+        "\n"
+        "1. e4 { comment\n"
+        "[not a tag] } *\n"
+        "\n"
+        "[Event \"z\"]\n"
+        "1. d4 *\n"
+    };
+
+    PgnScanner pgnScanner { input.data(), input.size() };
+
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_START);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_KEY);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 1);
+
+    // skip to the tag pair after the comment
+    EXPECT_TRUE(pgnScanner.skipToNextGame());
+    EXPECT_EQ(pgnScanner.getLineNumber(), 5);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_START);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_KEY);
+    EXPECT_EQ(std::string_view(pgnScanner.YYText(), pgnScanner.YYLeng()), "not");
+
+    // skip to the last game
+    EXPECT_TRUE(pgnScanner.skipToNextGame());
+    EXPECT_EQ(pgnScanner.getLineNumber(), 7);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_START);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_KEY);
+    EXPECT_EQ(std::string_view(pgnScanner.YYText(), pgnScanner.YYLeng()), "Event");
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_VALUE);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_END);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::MOVENUM);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 8);
+
+    // no more games
+    EXPECT_FALSE(pgnScanner.skipToNextGame());
+    EXPECT_EQ(pgnScanner.getCurrentToken(), PgnScannerToken::END_OF_FILE);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 9);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::END_OF_FILE);
+}
+
+TEST(PgnScannerTest, countNewlines)
+{
+    std::string input { };
+    for (std::size_t i { }; i < 100U; ++i)
+        input.push_back((i % 3U == 0U || i % 7U == 0U) ? '\n' : static_cast<char>(0x8A + i));
+
+    for (std::size_t begin { }; begin < 16U; ++begin)
+        for (std::size_t end { begin }; end <= input.size(); ++end)
+        {
+            const char *const b { input.data() + begin };
+            const char *const e { input.data() + end };
+
+            EXPECT_EQ(PgnScanner::countNewlines(b, e), static_cast<std::size_t>(std::count(b, e, '\n')));
+        }
+
+    EXPECT_EQ(PgnScanner::countNewlines(input.data(), input.data()), 0U);
+}
+
+TEST(PgnScannerTest, getLineNumber)
+{
+    constexpr std::string_view input {
+        "[Event \"x\"]\n"
+        "\n"
+        "{ multi\n"
+        "line\n"
+        "comment } 1. e4\n"
+        "*\n"
+    };
+
+    PgnScanner pgnScanner { input.data(), input.size() };
+
+    EXPECT_EQ(pgnScanner.getLineNumber(), 1U);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_START);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 1U);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_KEY);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_VALUE);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::TAG_END);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 1U);
+
+    // line number at the end of the comment
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::COMMENT_START);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 3U);
+    while (pgnScanner.nextToken() != PgnScannerToken::COMMENT_END);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 5U);
+
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::MOVENUM);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 5U);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 5U);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::MOVE_PAWN);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::RESULT);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 6U);
+    EXPECT_EQ(pgnScanner.nextToken(), PgnScannerToken::END_OF_FILE);
+    EXPECT_EQ(pgnScanner.getLineNumber(), 7U);
+}
+
 // just make sure the scanner deals with all 2-char inputs in all modes
 TEST(PgnScannerTest, exhaustive2CharTokens)
 {
@@ -0,0 +1,156 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__BOUNDED_SPMC_QUEUE_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__BOUNDED_SPMC_QUEUE_H_INCLUDED
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace hoover_chess_utils::utils
+{
+
+// Lock-free bounded single-producer, multi-consumer queue of trivially
+// copyable values. Every cell carries a sequence number that tells whether the
+// cell is ready for the producer or for a consumer (D. Vyukov's bounded
+// queue). The producer needs no atomic read-modify-write operations, and the
+// consumers claim the cells with a compare-and-swap.
+//
+// push() and pop() block by waiting on the queue positions when the queue is
+// full or empty, respectively.
+template <typename T>
+class BoundedSpmcQueue
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+private:
+    static constexpr std::size_t ctCacheLineSize { 64U };
+
+    struct alignas(ctCacheLineSize) Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    const std::size_t m_mask;
+
+    alignas(ctCacheLineSize) std::atomic<std::size_t> m_pushPos { };
+    alignas(ctCacheLineSize) std::atomic<std::size_t> m_popPos { };
+
+public:
+    // Capacity is rounded up to the next power of two
+    explicit BoundedSpmcQueue(std::size_t capacity) :
+        m_cells { std::make_unique<Cell[]>(std::bit_ceil(capacity)) },
+        m_mask { std::bit_ceil(capacity) - 1U }
+    {
+        for (std::size_t i { }; i <= m_mask; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedSpmcQueue(const BoundedSpmcQueue &) = delete;
+    BoundedSpmcQueue(BoundedSpmcQueue &&) = delete;
+    BoundedSpmcQueue &operator = (const BoundedSpmcQueue &) & = delete;
+    BoundedSpmcQueue &operator = (BoundedSpmcQueue &&) & = delete;
+    ~BoundedSpmcQueue() = default;
+
+    // Producer only. Returns false if the queue is full.
+    bool tryPush(T value) noexcept
+    {
+        const std::size_t pos { m_pushPos.load(std::memory_order_relaxed) };
+        Cell &cell { m_cells[pos & m_mask] };
+
+        if (cell.sequence.load(std::memory_order_acquire) != pos)
+            return false;
+
+        cell.value = value;
+        cell.sequence.store(pos + 1U, std::memory_order_release);
+        m_pushPos.store(pos + 1U, std::memory_order_release);
+        m_pushPos.notify_all();
+
+        return true;
+    }
+
+    // Returns false if the queue is empty
+    bool tryPop(T &value) noexcept
+    {
+        std::size_t pos { m_popPos.load(std::memory_order_relaxed) };
+
+        while (true)
+        {
+            Cell &cell { m_cells[pos & m_mask] };
+            const std::size_t sequence { cell.sequence.load(std::memory_order_acquire) };
+
+            if (sequence == pos + 1U)
+            {
+                // cell is filled, try to claim it
+                if (m_popPos.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed))
+                {
+                    value = cell.value;
+                    cell.sequence.store(pos + m_mask + 1U, std::memory_order_release);
+                    m_popPos.notify_all();
+
+                    return true;
+                }
+            }
+            else if (sequence == pos)
+            {
+                // empty
+                return false;
+            }
+            else
+            {
+                // another consumer got the cell first
+                pos = m_popPos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Producer only. Blocks while the queue is full.
+    void push(T value) noexcept
+    {
+        while (!tryPush(value))
+        {
+            // wait until a consumer advances
+            const std::size_t popPos { m_popPos.load(std::memory_order_acquire) };
+            if (m_pushPos.load(std::memory_order_relaxed) - popPos > m_mask)
+                m_popPos.wait(popPos, std::memory_order_acquire);
+        }
+    }
+
+    // Blocks while the queue is empty
+    T pop() noexcept
+    {
+        T value;
+
+        while (!tryPop(value))
+        {
+            // wait until the producer advances
+            const std::size_t pushPos { m_pushPos.load(std::memory_order_acquire) };
+            if (pushPos == m_popPos.load(std::memory_order_relaxed))
+                m_pushPos.wait(pushPos, std::memory_order_acquire);
+        }
+
+        return value;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "bump-arena.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace hoover_chess_utils::utils
+{
+
+void *BumpArena::allocateSlow(std::size_t bytes, std::size_t alignment)
+{
+    // worst-case space requirement, including alignment padding
+    const std::size_t requiredSize { bytes + alignment - 1U };
+
+    // try the retained chunks first. Chunks that are too small are skipped
+    // until the next reset().
+    std::size_t nextChunkIndex { m_cur == nullptr ? 0U : m_curChunkIndex + 1U };
+
+    while (nextChunkIndex < m_chunks.size() && m_chunks[nextChunkIndex].size < requiredSize)
+        ++nextChunkIndex;
+
+    if (nextChunkIndex == m_chunks.size())
+    {
+        // out of chunks, allocate a new one
+        const std::size_t chunkSize { std::max(ctMinChunkSize, requiredSize) };
+        m_chunks.push_back(Chunk { std::make_unique_for_overwrite<std::byte[]>(chunkSize), chunkSize });
+    }
+
+    Chunk &chunk { m_chunks[nextChunkIndex] };
+    m_curChunkIndex = nextChunkIndex;
+
+    const std::uintptr_t start { reinterpret_cast<std::uintptr_t>(chunk.data.get()) };
+    const std::uintptr_t aligned { (start + alignment - 1U) & ~static_cast<std::uintptr_t>(alignment - 1U) };
+
+    std::byte *const ret { chunk.data.get() + (aligned - start) };
+    m_cur = ret + bytes;
+    m_end = chunk.data.get() + chunk.size;
+
+    return ret;
+}
+
+}
@@ -0,0 +1,122 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__BUMP_ARENA_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__BUMP_ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace hoover_chess_utils::utils
+{
+
+// Bump allocator for short-lived data, such as the tags and comments of a
+// single game. Deallocation is a no-op, and reset() makes all memory
+// available again without returning it to the system. Chunks are retained
+// over resets, so once the arena has grown to fit the largest game, there is
+// no further heap traffic.
+//
+// Note: all containers allocated from the arena must be discarded before
+// reset() is called.
+class BumpArena final : public std::pmr::memory_resource
+{
+private:
+    static constexpr std::size_t ctMinChunkSize { 65536U };
+
+    struct Chunk
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Chunk> m_chunks { };
+    std::size_t m_curChunkIndex { };
+    std::byte *m_cur { };
+    std::byte *m_end { };
+
+    void *allocateSlow(std::size_t bytes, std::size_t alignment);
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        const std::uintptr_t cur { reinterpret_cast<std::uintptr_t>(m_cur) };
+        const std::uintptr_t aligned { (cur + alignment - 1U) & ~static_cast<std::uintptr_t>(alignment - 1U) };
+        const std::size_t padding { aligned - cur };
+
+        if (m_cur != nullptr && padding + bytes <= static_cast<std::size_t>(m_end - m_cur)) [[likely]]
+        {
+            std::byte *const ret { m_cur + padding };
+            m_cur = ret + bytes;
+            return ret;
+        }
+        else [[unlikely]]
+        {
+            return allocateSlow(bytes, alignment);
+        }
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        static_cast<void>(p);
+        static_cast<void>(bytes);
+        static_cast<void>(alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+public:
+    BumpArena() = default;
+    BumpArena(const BumpArena &) = delete;
+    BumpArena(BumpArena &&) = delete;
+    BumpArena &operator = (const BumpArena &) & = delete;
+    BumpArena &operator = (BumpArena &&) & = delete;
+    ~BumpArena() override = default;
+
+    // Releases all allocations. The chunks are kept for reuse.
+    void reset() noexcept
+    {
+        m_curChunkIndex = 0U;
+
+        if (m_chunks.empty())
+        {
+            m_cur = nullptr;
+            m_end = nullptr;
+        }
+        else
+        {
+            m_cur = m_chunks.front().data.get();
+            m_end = m_cur + m_chunks.front().size;
+        }
+    }
+};
+
+// Arena-backed string and vector types. Use with BumpArena as the memory
+// resource.
+using ArenaString = std::pmr::string;
+
+template <typename T>
+using ArenaVector = std::pmr::vector<T>;
+
+}
+
+#endif
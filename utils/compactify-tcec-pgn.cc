@@ -18,6 +18,7 @@
 #include "pgnreader-string-utils.h"
 #include "version.h"
 
+#include "bump-arena.h"
 #include "memory-mapped-file.h"
 #include "output-buffer.h"
 
@@ -27,6 +28,7 @@
 #include <format>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace hoover_chess_utils::utils
@@ -61,9 +63,12 @@ private:
 
     std::uint32_t m_gameNo { };
 
+    // Storage for the per-game tags. Reset on game start.
+    BumpArena m_arena { };
+
     // PGN tags of the game
-    std::vector<std::tuple<std::string, std::string>> m_pgnTags { };
-    std::string m_pgnResultTag { };
+    ArenaVector<std::pair<ArenaString, ArenaString>> m_pgnTags { &m_arena };
+    ArenaString m_pgnResultTag { &m_arena };
 
     // moves of the game
     std::vector<pgn_reader::Move> m_moves { };
@@ -80,16 +85,8 @@ private:
     static constexpr std::string_view ctLiteralResultBlackWin { "0-1" };
     static constexpr std::string_view ctLiteralDoubleNewLine { "\n\n" };
 
-    void writeEscapedPgnValue(const std::string_view value)
-    {
-        for (char c : value)
-        {
-            if (c == '\\' || c == '"')
-                out.write('\\');
-
-            out.write(c);
-        }
-    }
+    // space + move number + space + SAN + book exit comment
+    static constexpr std::size_t ctMaxMoveTextLength { 1U + 13U + 1U + 7U + ctLiteralBookExitPrefixSpace.size() };
 
     void printMoves()
     {
@@ -103,29 +100,36 @@ private:
 
         for (size_t moveIndex { }; moveIndex < m_moves.size(); ++moveIndex)
         {
+            // separator, move number, SAN and book exit comment with a
+            // single reservation
+            char *const begin { out.reserve(ctMaxMoveTextLength) };
+            char *p { begin };
+
             if (moveIndex != 0U)
-                out.write(' ');
+                *p++ = ' ';
 
             const std::uint_fast32_t plyNum { board.getCurrentPlyNum() };
             if (forceMoveNum || pgn_reader::colorOfPly(plyNum) == pgn_reader::Color::WHITE)
             {
-                out.write(pgn_reader::StringUtils::moveNumToString(pgn_reader::moveNumOfPly(plyNum), pgn_reader::colorOfPly(plyNum)));
-                out.write(' ');
+                p = OutputBuffer::put(p, pgn_reader::StringUtils::moveNumToString(pgn_reader::moveNumOfPly(plyNum), pgn_reader::colorOfPly(plyNum)).getStringView());
+                *p++ = ' ';
 
                 forceMoveNum = false;
             }
 
-            out.write(pgn_reader::StringUtils::moveToSanAndPlay(board, m_moves[moveIndex]));
+            p = OutputBuffer::put(p, pgn_reader::StringUtils::moveToSanAndPlay(board, m_moves[moveIndex]).getStringView());
 
             if (board.getCurrentPlyNum() == m_lastBookPly)
             {
-                out.write(ctLiteralBookExitPrefixSpace);
+                p = OutputBuffer::put(p, ctLiteralBookExitPrefixSpace);
                 forceMoveNum = true;
             }
+
+            out.commit(static_cast<std::size_t>(p - begin));
         }
     }
 
-    static bool pgnTagKeyLess(const std::string &lhs, const std::string &rhs)
+    static bool pgnTagKeyLess(std::string_view lhs, std::string_view rhs)
     {
 #define C(key)                                  \
         {                                       \
@@ -170,9 +174,14 @@ public:
     void gameStart() override
     {
         ++m_gameNo;
-        m_pgnTags.clear();
+
+        // Discard the arena-backed containers before resetting the
+        // arena. Deallocation is a no-op, so this just drops the storage.
+        m_pgnTags = ArenaVector<std::pair<ArenaString, ArenaString>> { &m_arena };
+        m_pgnResultTag = ArenaString { &m_arena };
+        m_arena.reset();
+
         m_pgnTags.reserve(32U);
-        m_pgnResultTag.clear();
         m_moves.clear();
         m_moves.reserve(512U);
         m_bookDetectionMode = BookDetectionMode::NONE;
@@ -210,7 +219,7 @@ public:
         if (key == "Result")
             m_pgnResultTag = value;
 
-        m_pgnTags.push_back(std::make_tuple(std::string { key }, std::string { value }));
+        m_pgnTags.emplace_back(key, value);
     }
 
     void moveTextSection() override
@@ -229,16 +238,16 @@ public:
                 m_pgnTags.begin(), m_pgnTags.end(),
                 [] (const auto &lhs, const auto &rhs) -> bool
                 {
-                    return pgnTagKeyLess(std::get<0>(lhs), std::get<0>(rhs));
+                    return pgnTagKeyLess(lhs.first, rhs.first);
                 });
         }
 
         for (const auto &tagPair : m_pgnTags)
         {
             out.write('[');
-            out.write(std::string_view(std::get<0>(tagPair)));
+            out.write(std::string_view(tagPair.first));
             out.write(std::string_view { " \"" });
-            writeEscapedPgnValue(std::string_view(std::get<1>(tagPair)));
+            out.writeEscapedPgnValue(std::string_view(tagPair.second));
             out.write(std::string_view { "\"]\n" });
         }
 
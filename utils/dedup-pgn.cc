@@ -0,0 +1,333 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "memory-mapped-file.h"
+#include "output-buffer.h"
+#include "pgn-segments.h"
+#include "position-fingerprint.h"
+#include "process-in-order.h"
+#include "to-number.h"
+
+#include "chessboard.h"
+#include "pgnreader.h"
+#include "position-compress-fixed.h"
+#include "version.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace hoover_chess_utils::utils
+{
+
+namespace
+{
+
+void printHelp()
+{
+    std::cout << "PGN deduplicating merge tool (" << hoover_chess_utils::pgn_reader::getVersionString() << ')' << std::endl;
+    std::cout << std::endl;
+    std::cout << "Usage: hoover-dedup-pgn [options] <PGN-file>..." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Merges the PGN files to stdout, keeping only the first occurrence of every game." << std::endl;
+    std::cout << "By default, games are duplicates when they have the same starting position and" << std::endl;
+    std::cout << "the same mainline moves." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "--threads <n>        Number of threads (default: hardware threads)" << std::endl;
+    std::cout << "--tags <key,...>     Games are duplicates only if the values of these PGN tags" << std::endl;
+    std::cout << "                     are also the same. Example: --tags White,Black,Result" << std::endl;
+    std::cout << "--exact              Games are duplicates only if their PGN texts are identical" << std::endl;
+}
+
+inline std::uint64_t mixFingerprint(std::uint64_t h, std::uint64_t v) noexcept
+{
+    h ^= v * UINT64_C(0x9E3779B97F4A7C15);
+    h = std::rotl(h, 27) * UINT64_C(0xC2B2AE3D27D4EB4F);
+    return h ^ (h >> 31U);
+}
+
+std::uint64_t stringFingerprint(std::string_view str) noexcept
+{
+    return mixFingerprint(std::hash<std::string_view> { }(str), str.size());
+}
+
+struct DedupOptions
+{
+    // PGN tags included in the game fingerprint
+    std::vector<std::string> tags;
+
+    // fingerprint of the PGN text instead of the game contents
+    bool exact;
+};
+
+// Game fingerprint from the starting position, the mainline moves, and the
+// values of the selected PGN tags. The moves are hashed in their compact
+// 16-bit encoding, four moves at a time.
+std::uint64_t gameFingerprint(const pgn_reader::PgnGameView &game, const DedupOptions &options)
+{
+    pgn_reader::CompressedPosition_FixedLength cp;
+    pgn_reader::PositionCompressor_FixedLength::compress(*game.initialBoard, cp);
+
+    std::uint64_t h { positionFingerprint(cp) };
+
+    std::uint64_t word { };
+    for (std::size_t i { }; i < game.moves.size(); ++i)
+    {
+        word = (word << 16U) | pgn_reader::CompactMove { game.moves[i] }.getEncodedValue();
+
+        if (i % 4U == 3U)
+        {
+            h = mixFingerprint(h, word);
+            word = 0U;
+        }
+    }
+
+    h = mixFingerprint(h, word);
+    h = mixFingerprint(h, game.moves.size());
+
+    for (const std::string &key : options.tags)
+    {
+        const auto i {
+            std::find_if(game.tags.begin(), game.tags.end(),
+                         [&key](const pgn_reader::PgnGameTag &tag) noexcept
+                         {
+                             return tag.key == key;
+                         }) };
+
+        // a missing tag is not the same as an empty tag
+        h = mixFingerprint(h, i != game.tags.end() ? stringFingerprint(i->value) : 0U);
+    }
+
+    return h;
+}
+
+// Open-addressing hash set of game fingerprints. Fingerprint 0 marks an
+// empty slot. The set grows by doubling, so the memory use is proportional
+// to the number of distinct games.
+class FingerprintSet
+{
+private:
+    std::unique_ptr<std::uint64_t[]> m_slots { };
+    std::size_t m_numSlots { };
+    std::size_t m_numEntries { };
+
+    bool insertInternal(std::uint64_t fingerprint) noexcept
+    {
+        const std::size_t mask { m_numSlots - 1U };
+        std::size_t slot { fingerprint & mask };
+
+        while (m_slots[slot] != 0U)
+        {
+            if (m_slots[slot] == fingerprint)
+                return false;
+
+            slot = (slot + 1U) & mask;
+        }
+
+        m_slots[slot] = fingerprint;
+        ++m_numEntries;
+        return true;
+    }
+
+    void grow()
+    {
+        std::unique_ptr<std::uint64_t[]> oldSlots { std::move(m_slots) };
+        const std::size_t oldNumSlots { m_numSlots };
+
+        m_numSlots = std::max<std::size_t>(oldNumSlots * 2U, 1U << 16U);
+        m_slots = std::make_unique<std::uint64_t[]>(m_numSlots);
+        m_numEntries = 0U;
+
+        for (std::size_t i { }; i < oldNumSlots; ++i)
+        {
+            if (oldSlots[i] != 0U)
+                insertInternal(oldSlots[i]);
+        }
+    }
+
+public:
+    // Inserts a fingerprint. Returns false if the fingerprint was already in
+    // the set.
+    bool insert(std::uint64_t fingerprint)
+    {
+        if (fingerprint == 0U) [[unlikely]]
+            fingerprint = 1U;
+
+        // keep the load factor at most 3/4
+        if (m_numEntries >= m_numSlots / 4U * 3U) [[unlikely]]
+            grow();
+
+        return insertInternal(fingerprint);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_numEntries;
+    }
+};
+
+struct GameEntry
+{
+    std::uint64_t fingerprint;
+
+    // game text range in the segment
+    std::uint64_t offset;
+    std::uint64_t length;
+};
+
+std::vector<std::string> parseTagList(std::string_view tagList)
+{
+    std::vector<std::string> tags { };
+
+    while (!tagList.empty())
+    {
+        const std::size_t comma { std::min(tagList.find(','), tagList.size()) };
+
+        if (comma != 0U)
+            tags.emplace_back(tagList.substr(0U, comma));
+
+        tagList.remove_prefix(std::min(comma + 1U, tagList.size()));
+    }
+
+    return tags;
+}
+
+int dedupPgnMain(int argc, char **argv) noexcept
+{
+    try
+    {
+        std::size_t numThreads { std::max<std::size_t>(std::thread::hardware_concurrency(), 1U) };
+        DedupOptions options { };
+        std::vector<MemoryMappedFile> files { };
+
+        int argi { 1 };
+        for (; argi < argc; ++argi)
+        {
+            const std::string_view arg { argv[argi] };
+
+            if (arg == "--exact")
+                options.exact = true;
+            else if (arg == "--threads" && argi + 1 < argc)
+                numThreads = std::clamp(toNumber<std::size_t>(argv[++argi]), std::size_t { 1U }, std::size_t { 256U });
+            else if (arg == "--tags" && argi + 1 < argc)
+                options.tags = parseTagList(argv[++argi]);
+            else if (arg.starts_with("--"))
+            {
+                printHelp();
+                return 127;
+            }
+            else
+                break;
+        }
+
+        if (argi == argc)
+        {
+            printHelp();
+            return 127;
+        }
+
+        files.resize(argc - argi);
+        for (std::size_t i { }; i < files.size(); ++i)
+            files[i].map(argv[argi + i], true, false);
+
+        std::size_t totalSize { };
+        for (const MemoryMappedFile &file : files)
+            totalSize += file.size();
+
+        const std::vector<std::string_view> segments {
+            splitIntoSegments(files, targetSegmentSizeForThreads(totalSize, numThreads)) };
+
+        std::vector<std::vector<GameEntry> > segmentGames(segments.size());
+        FingerprintSet seenGames { };
+        std::size_t numGames { };
+        OutputBuffer out { };
+
+        // Games are fingerprinted in parallel. The fingerprints are inserted
+        // in the input order, so that the first occurrence of every game is
+        // kept.
+        processInOrder(
+            segments.size(), numThreads,
+            [&](std::size_t i)
+            {
+                pgn_reader::PgnGameReader reader { segments[i] };
+
+                for (const pgn_reader::PgnGameView &game : reader)
+                {
+                    const std::string_view gameText { segments[i].substr(game.inputOffset, game.inputLength) };
+
+                    segmentGames[i].push_back(
+                        GameEntry {
+                            options.exact ? stringFingerprint(gameText) : gameFingerprint(game, options),
+                            game.inputOffset, game.inputLength });
+                }
+            },
+            [&](std::size_t i)
+            {
+                for (const GameEntry &entry : segmentGames[i])
+                {
+                    if (seenGames.insert(entry.fingerprint))
+                    {
+                        out.write(segments[i].substr(entry.offset, entry.length));
+                        out.write("\n\n");
+                    }
+                }
+
+                numGames += segmentGames[i].size();
+
+                // release the memory
+                std::vector<GameEntry> { }.swap(segmentGames[i]);
+            });
+
+        out.flush();
+
+        std::cerr << std::format("Games read: {}, unique games written: {}, duplicates removed: {}",
+                                 numGames, seenGames.size(), numGames - seenGames.size())
+                  << std::endl;
+
+        return 0;
+    }
+    catch (const pgn_reader::PgnError &pgnError)
+    {
+        std::cerr << pgnError.what() << std::endl;
+
+        return 1;
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+
+        return 2;
+    }
+}
+
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    return hoover_chess_utils::utils::dedupPgnMain(argc, argv);
+}
@@ -0,0 +1,483 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__EXTERNAL_POSITION_SORT_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__EXTERNAL_POSITION_SORT_H_INCLUDED
+
+#include "position-compress-fixed.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace hoover_chess_utils::utils
+{
+
+// External-memory sorter for fixed-size records keyed by a compressed
+// position. The records are sorted in the order of
+// CompressedPosition_FixedLength::operator <=>, and records with equal keys
+// are combined into one.
+//
+// The records are collected in a memory buffer. When the buffer is full, it
+// is sorted with a multi-threaded LSD radix sort, the equal keys are
+// combined, and the result is spilled to disk as a sorted run. finish()
+// k-way merges the runs and streams the result to the caller. If there are
+// too many runs to merge within the memory budget, the runs are first merged
+// in groups. When all records fit in memory, nothing is written to disk.
+//
+// T_Traits must provide:
+// - static const pgn_reader::CompressedPosition_FixedLength &getKey(const T_Record &)
+// - static void combine(T_Record &into, const T_Record &from)
+//
+// The run files are created in the temporary directory and unlinked right
+// away, so they are removed even if the process is terminated.
+template <typename T_Record, typename T_Traits>
+class ExternalPositionSorter
+{
+    static_assert(std::is_trivially_copyable_v<T_Record>);
+
+private:
+    using KeyWords = std::array<std::uint64_t, 3U>;
+    static_assert(sizeof(KeyWords) == sizeof(pgn_reader::CompressedPosition_FixedLength));
+
+    // LSD radix sort: 11-bit digits, 6 digits per key word
+    static constexpr unsigned ctDigitBits { 11U };
+    static constexpr std::size_t ctNumBuckets { std::size_t { 1U } << ctDigitBits };
+    static constexpr unsigned ctDigitsPerWord { (64U + ctDigitBits - 1U) / ctDigitBits };
+    static constexpr unsigned ctNumPasses { ctDigitsPerWord * 3U };
+
+    // minimum input buffer per run during merging
+    static constexpr std::size_t ctMinReadBufferSize { 65536U };
+
+    // disk-backed sorted run
+    class Run
+    {
+    private:
+        std::FILE *m_file { };
+        std::vector<T_Record> m_buf { };
+        std::size_t m_pos { };
+        std::size_t m_count { };
+
+    public:
+        explicit Run(const std::filesystem::path &path)
+        {
+            m_file = std::fopen(path.c_str(), "w+b");
+            if (m_file == nullptr)
+                throw std::system_error(errno, std::generic_category(), std::format("Failed to create {}", path.string()));
+
+            std::error_code ec { };
+            std::filesystem::remove(path, ec);
+        }
+
+        Run(const Run &) = delete;
+        Run(Run &&) = delete;
+        Run &operator = (const Run &) & = delete;
+        Run &operator = (Run &&) & = delete;
+
+        ~Run()
+        {
+            std::fclose(m_file);
+        }
+
+        void write(const T_Record *records, std::size_t numRecords)
+        {
+            if (numRecords != 0U && std::fwrite(records, sizeof(T_Record), numRecords, m_file) != numRecords)
+                throw std::system_error(errno, std::generic_category(), "Failed to write a sorted run");
+        }
+
+        // Switches to reading with a buffer of given size
+        void rewind(std::size_t bufferRecords)
+        {
+            if (std::fflush(m_file) != 0 || std::fseek(m_file, 0, SEEK_SET) != 0)
+                throw std::system_error(errno, std::generic_category(), "Failed to rewind a sorted run");
+
+            m_buf.resize(std::max<std::size_t>(bufferRecords, 1U));
+            m_pos = 0U;
+            m_count = 0U;
+        }
+
+        // Returns nullptr at the end of the run
+        const T_Record *peek()
+        {
+            if (m_pos == m_count) [[unlikely]]
+            {
+                m_count = std::fread(m_buf.data(), sizeof(T_Record), m_buf.size(), m_file);
+                m_pos = 0U;
+
+                if (m_count == 0U)
+                {
+                    if (std::ferror(m_file))
+                        throw std::system_error(errno, std::generic_category(), "Failed to read a sorted run");
+
+                    return nullptr;
+                }
+            }
+
+            return &m_buf[m_pos];
+        }
+
+        void pop() noexcept
+        {
+            ++m_pos;
+        }
+    };
+
+    const std::filesystem::path m_tempDir;
+    const std::size_t m_memoryBudget;
+    const std::size_t m_numThreads;
+
+    std::vector<T_Record> m_records { };
+    std::vector<T_Record> m_scratch { };
+    std::size_t m_capacity { };
+
+    std::vector<std::unique_ptr<Run> > m_runs { };
+    std::size_t m_runCounter { };
+
+    static KeyWords getKeyWords(const T_Record &record) noexcept
+    {
+        KeyWords ret;
+        std::memcpy(ret.data(), &T_Traits::getKey(record), sizeof ret);
+        return ret;
+    }
+
+    static inline std::size_t getDigit(const T_Record &record, unsigned pass) noexcept
+    {
+        // least significant digit first. The first key word is the most
+        // significant one.
+        const std::size_t wordIndex { 2U - (pass / ctDigitsPerWord) };
+        const unsigned shift { (pass % ctDigitsPerWord) * ctDigitBits };
+
+        std::uint64_t word;
+        std::memcpy(&word, reinterpret_cast<const char *>(&T_Traits::getKey(record)) + (wordIndex * 8U), sizeof word);
+
+        return (word >> shift) & (ctNumBuckets - 1U);
+    }
+
+    // Sorts m_records, using m_scratch as the scatter buffer
+    void radixSort()
+    {
+        const std::size_t numRecords { m_records.size() };
+        const std::size_t numThreads {
+            std::clamp<std::size_t>(numRecords / 65536U, 1U, m_numThreads) };
+
+        m_scratch.resize(numRecords);
+
+        std::vector<std::array<std::size_t, ctNumBuckets> > histograms(numThreads);
+        T_Record *src { m_records.data() };
+        T_Record *dst { m_scratch.data() };
+
+        const auto chunkBegin = [numRecords, numThreads](std::size_t t) noexcept
+        {
+            return numRecords * t / numThreads;
+        };
+
+        const auto parallelFor = [numThreads](auto &&fn)
+        {
+            std::vector<std::jthread> threads { };
+
+            for (std::size_t t { 1U }; t < numThreads; ++t)
+                threads.emplace_back(fn, t);
+
+            fn(std::size_t { 0U });
+        };
+
+        for (unsigned pass { }; pass < ctNumPasses; ++pass)
+        {
+            parallelFor(
+                [&](std::size_t t)
+                {
+                    std::array<std::size_t, ctNumBuckets> &histogram { histograms[t] };
+                    histogram.fill(0U);
+
+                    for (std::size_t i { chunkBegin(t) }; i < chunkBegin(t + 1U); ++i)
+                        ++histogram[getDigit(src[i], pass)];
+                });
+
+            // bucket offsets per thread. Skip the pass if all records have
+            // the same digit.
+            bool trivialPass { };
+            std::size_t offset { };
+
+            for (std::size_t digit { }; digit < ctNumBuckets; ++digit)
+            {
+                std::size_t bucketSize { };
+
+                for (std::size_t t { }; t < numThreads; ++t)
+                {
+                    const std::size_t count { histograms[t][digit] };
+                    histograms[t][digit] = offset;
+                    offset += count;
+                    bucketSize += count;
+                }
+
+                if (bucketSize == numRecords)
+                    trivialPass = true;
+            }
+
+            if (trivialPass)
+                continue;
+
+            parallelFor(
+                [&](std::size_t t)
+                {
+                    std::array<std::size_t, ctNumBuckets> &offsets { histograms[t] };
+
+                    for (std::size_t i { chunkBegin(t) }; i < chunkBegin(t + 1U); ++i)
+                        dst[offsets[getDigit(src[i], pass)]++] = src[i];
+                });
+
+            std::swap(src, dst);
+        }
+
+        if (src != m_records.data())
+            std::copy(src, src + numRecords, m_records.data());
+    }
+
+    // Sorts the buffer and combines the records with equal keys
+    void sortAndCombine()
+    {
+        radixSort();
+
+        if (m_records.empty())
+            return;
+
+        std::size_t out { };
+        KeyWords outKey { getKeyWords(m_records[0U]) };
+
+        for (std::size_t i { 1U }; i < m_records.size(); ++i)
+        {
+            const KeyWords key { getKeyWords(m_records[i]) };
+
+            if (key == outKey)
+            {
+                T_Traits::combine(m_records[out], m_records[i]);
+            }
+            else
+            {
+                m_records[++out] = m_records[i];
+                outKey = key;
+            }
+        }
+
+        m_records.resize(out + 1U);
+    }
+
+    std::unique_ptr<Run> createRun()
+    {
+        return std::make_unique<Run>(
+            m_tempDir / std::format("hoover-sort-{}-{}-{}.run",
+                                    static_cast<long>(getpid()),
+                                    static_cast<const void *>(this),
+                                    m_runCounter++));
+    }
+
+    void spill()
+    {
+        sortAndCombine();
+
+        std::unique_ptr<Run> run { createRun() };
+        run->write(m_records.data(), m_records.size());
+        m_runs.push_back(std::move(run));
+
+        m_records.clear();
+    }
+
+    // Merges runs and invokes output(const T_Record &) for every combined
+    // record in key order
+    template <typename T_Output>
+    void mergeRuns(std::vector<std::unique_ptr<Run> > &runs, T_Output &&output)
+    {
+        const std::size_t bufferRecords {
+            std::max<std::size_t>(m_memoryBudget / runs.size(), ctMinReadBufferSize) / sizeof(T_Record) };
+
+        // min-heap of runs by the current key
+        std::vector<std::pair<KeyWords, Run *> > heap { };
+        heap.reserve(runs.size());
+
+        const auto heapCompare = [](const std::pair<KeyWords, Run *> &lhs, const std::pair<KeyWords, Run *> &rhs) noexcept
+        {
+            return lhs.first > rhs.first;
+        };
+
+        for (std::unique_ptr<Run> &run : runs)
+        {
+            run->rewind(bufferRecords);
+
+            if (const T_Record *const record { run->peek() })
+                heap.emplace_back(getKeyWords(*record), run.get());
+        }
+
+        std::make_heap(heap.begin(), heap.end(), heapCompare);
+
+        bool pending { };
+        KeyWords pendingKey { };
+        T_Record pendingRecord;
+
+        while (!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), heapCompare);
+            auto &[key, run] { heap.back() };
+
+            const T_Record &record { *run->peek() };
+
+            if (pending && key == pendingKey)
+            {
+                T_Traits::combine(pendingRecord, record);
+            }
+            else
+            {
+                if (pending)
+                    output(std::as_const(pendingRecord));
+
+                pendingRecord = record;
+                pendingKey = key;
+                pending = true;
+            }
+
+            run->pop();
+
+            if (const T_Record *const next { run->peek() })
+            {
+                key = getKeyWords(*next);
+                std::push_heap(heap.begin(), heap.end(), heapCompare);
+            }
+            else
+            {
+                heap.pop_back();
+            }
+        }
+
+        if (pending)
+            output(std::as_const(pendingRecord));
+    }
+
+public:
+    // tempDir: directory for the sorted runs
+    // memoryBudget: memory for the record buffers in bytes
+    // numThreads: number of threads for sorting
+    ExternalPositionSorter(std::filesystem::path tempDir, std::size_t memoryBudget, std::size_t numThreads) :
+        m_tempDir { std::move(tempDir) },
+        m_memoryBudget { std::max<std::size_t>(memoryBudget, 2U * ctMinReadBufferSize) },
+        m_numThreads { std::max<std::size_t>(numThreads, 1U) }
+    {
+        // record buffer and the radix sort scatter buffer
+        m_capacity = std::max<std::size_t>(m_memoryBudget / (2U * sizeof(T_Record)), 1U);
+        m_records.reserve(m_capacity);
+    }
+
+    ExternalPositionSorter(const ExternalPositionSorter &) = delete;
+    ExternalPositionSorter(ExternalPositionSorter &&) = delete;
+    ExternalPositionSorter &operator = (const ExternalPositionSorter &) & = delete;
+    ExternalPositionSorter &operator = (ExternalPositionSorter &&) & = delete;
+    ~ExternalPositionSorter() = default;
+
+    void add(const T_Record &record)
+    {
+        if (m_records.size() == m_capacity) [[unlikely]]
+            spill();
+
+        m_records.push_back(record);
+    }
+
+    std::size_t getNumSpilledRuns() const noexcept
+    {
+        return m_runs.size();
+    }
+
+    // Invokes output(const T_Record &) for every combined record in key
+    // order. The sorter is empty afterwards.
+    template <typename T_Output>
+    void finish(T_Output &&output)
+    {
+        if (m_runs.empty())
+        {
+            // everything fits in memory
+            sortAndCombine();
+
+            for (const T_Record &record : m_records)
+                output(record);
+
+            m_records.clear();
+            std::vector<T_Record> { }.swap(m_scratch);
+            return;
+        }
+
+        if (!m_records.empty())
+            spill();
+
+        // release the sort buffers for the merge
+        std::vector<T_Record> { }.swap(m_records);
+        std::vector<T_Record> { }.swap(m_scratch);
+
+        // merge in groups until the runs can be merged in one pass
+        const std::size_t maxFanIn { std::max<std::size_t>(m_memoryBudget / ctMinReadBufferSize, 2U) };
+
+        while (m_runs.size() > maxFanIn)
+        {
+            std::vector<std::unique_ptr<Run> > group { };
+            std::vector<std::unique_ptr<Run> > remaining { };
+
+            for (std::size_t i { }; i < m_runs.size(); ++i)
+                (i < maxFanIn ? group : remaining).push_back(std::move(m_runs[i]));
+
+            std::unique_ptr<Run> merged { createRun() };
+            std::vector<T_Record> writeBuffer { };
+            writeBuffer.reserve(ctMinReadBufferSize / sizeof(T_Record) + 1U);
+
+            mergeRuns(
+                group,
+                [&merged, &writeBuffer](const T_Record &record)
+                {
+                    writeBuffer.push_back(record);
+
+                    if (writeBuffer.size() == writeBuffer.capacity())
+                    {
+                        merged->write(writeBuffer.data(), writeBuffer.size());
+                        writeBuffer.clear();
+                    }
+                });
+
+            merged->write(writeBuffer.data(), writeBuffer.size());
+
+            // merged runs go last to keep the group sizes balanced
+            remaining.push_back(std::move(merged));
+            m_runs = std::move(remaining);
+        }
+
+        mergeRuns(m_runs, output);
+        m_runs.clear();
+        m_records.reserve(m_capacity);
+    }
+};
+
+}
+
+#endif
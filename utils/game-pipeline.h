@@ -0,0 +1,253 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__GAME_PIPELINE_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__GAME_PIPELINE_H_INCLUDED
+
+#include "pgnreader.h"
+
+#include "bounded-spmc-queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace hoover_chess_utils::utils
+{
+
+// Parses games in a dedicated thread and processes them in worker threads,
+// while completing them in the input order in the calling thread.
+//
+// For every game, in this order:
+// - prepare(T_Record &, const PgnGameView &) is invoked in the parser thread,
+//   in the input order. This copies the data needed by the later stages into
+//   the record and does any processing that depends on the previous games.
+// - process(T_Record &) is invoked in a worker thread, in any order.
+// - complete(T_Record &) is invoked in the thread that called run(), in the
+//   input order.
+//
+// The records are allocated once and recycled through a free list, so they
+// can keep their buffers between games. The number of records bounds the
+// number of games in flight.
+//
+// If any stage throws, no further games are parsed, the games already in
+// flight are drained without completion, and the exception is rethrown from
+// run(). Games preceding the failed one are completed.
+template <typename T_Record>
+class GamePipeline
+{
+private:
+    struct Slot
+    {
+        T_Record record { };
+        std::uint64_t sequenceNumber { };
+        std::exception_ptr error { };
+        bool endOfInput { };
+    };
+
+    const std::size_t m_numWorkers;
+    const std::size_t m_numSlots;
+
+    std::vector<std::unique_ptr<Slot> > m_slots { };
+
+    // Free slots, from the completing thread to the parser thread
+    BoundedSpmcQueue<Slot *> m_freeQueue;
+
+    // Parsed games, from the parser thread to the workers. nullptr terminates
+    // a worker.
+    BoundedSpmcQueue<Slot *> m_workQueue;
+
+    // Processed games, indexed by sequence number modulo the number of slots
+    std::unique_ptr<std::atomic<Slot *>[]> m_processed;
+
+    // Set when any stage fails. Stops the parser.
+    std::atomic<bool> m_stopRequested { };
+
+    template <typename T_Prepare>
+    void parserThreadMain(std::string_view pgn, T_Prepare &prepare) noexcept
+    {
+        std::uint64_t sequenceNumber { };
+        std::exception_ptr error { };
+
+        try
+        {
+            pgn_reader::PgnGameReader reader { pgn };
+
+            while (!m_stopRequested.load(std::memory_order_relaxed) && reader.nextGame())
+            {
+                Slot *const slot { m_freeQueue.pop() };
+                slot->sequenceNumber = sequenceNumber++;
+                slot->error = nullptr;
+                slot->endOfInput = false;
+
+                try
+                {
+                    prepare(slot->record, reader.getGame());
+                }
+                catch (...)
+                {
+                    slot->error = std::current_exception();
+                    m_stopRequested.store(true, std::memory_order_relaxed);
+                }
+
+                m_workQueue.push(slot);
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        // end of input marker, which also carries a parse error
+        Slot *const slot { m_freeQueue.pop() };
+        slot->sequenceNumber = sequenceNumber;
+        slot->error = error;
+        slot->endOfInput = true;
+        m_workQueue.push(slot);
+
+        for (std::size_t i { }; i < m_numWorkers; ++i)
+            m_workQueue.push(nullptr);
+    }
+
+    template <typename T_Process>
+    void workerThreadMain(T_Process &process) noexcept
+    {
+        while (Slot *const slot { m_workQueue.pop() })
+        {
+            // note: games in flight are processed even when a stop is
+            // requested, since the preceding games are completed
+            if (!slot->endOfInput && slot->error == nullptr)
+            {
+                try
+                {
+                    process(slot->record);
+                }
+                catch (...)
+                {
+                    slot->error = std::current_exception();
+                    m_stopRequested.store(true, std::memory_order_relaxed);
+                }
+            }
+
+            std::atomic<Slot *> &processed { m_processed[slot->sequenceNumber % m_numSlots] };
+            processed.store(slot, std::memory_order_release);
+            processed.notify_one();
+        }
+    }
+
+public:
+    // numWorkers: number of worker threads, at least 1
+    // numRecords: number of records (games in flight), at least 2
+    GamePipeline(std::size_t numWorkers, std::size_t numRecords) :
+        m_numWorkers { std::max<std::size_t>(numWorkers, 1U) },
+        m_numSlots { std::max<std::size_t>(numRecords, 2U) },
+        m_freeQueue { m_numSlots },
+        m_workQueue { m_numSlots + m_numWorkers },
+        m_processed { std::make_unique<std::atomic<Slot *>[]>(m_numSlots) }
+    {
+        m_slots.reserve(m_numSlots);
+        for (std::size_t i { }; i < m_numSlots; ++i)
+        {
+            m_slots.push_back(std::make_unique<Slot>());
+            m_freeQueue.push(m_slots.back().get());
+        }
+    }
+
+    GamePipeline(const GamePipeline &) = delete;
+    GamePipeline(GamePipeline &&) = delete;
+    GamePipeline &operator = (const GamePipeline &) & = delete;
+    GamePipeline &operator = (GamePipeline &&) & = delete;
+    ~GamePipeline() = default;
+
+    template <typename T_Prepare, typename T_Process, typename T_Complete>
+    void run(std::string_view pgn, T_Prepare &&prepare, T_Process &&process, T_Complete &&complete)
+    {
+        std::exception_ptr error { };
+
+        m_stopRequested.store(false, std::memory_order_relaxed);
+
+        {
+            std::vector<std::jthread> threads { };
+            threads.reserve(m_numWorkers + 1U);
+
+            try
+            {
+                for (std::size_t i { }; i < m_numWorkers; ++i)
+                    threads.emplace_back([this, &process]() { workerThreadMain(process); });
+
+                threads.emplace_back([this, pgn, &prepare]() { parserThreadMain(pgn, prepare); });
+            }
+            catch (...)
+            {
+                // parser thread was not started, so terminate the workers
+                for (std::size_t i { }; i < threads.size(); ++i)
+                    m_workQueue.push(nullptr);
+
+                throw;
+            }
+
+            // complete in input order until the end of input marker
+            for (std::uint64_t sequenceNumber { }; ; ++sequenceNumber)
+            {
+                std::atomic<Slot *> &processed { m_processed[sequenceNumber % m_numSlots] };
+
+                processed.wait(nullptr, std::memory_order_acquire);
+                Slot *const slot { processed.exchange(nullptr, std::memory_order_relaxed) };
+
+                if (error == nullptr)
+                {
+                    error = slot->error;
+
+                    if (error == nullptr && !slot->endOfInput)
+                    {
+                        try
+                        {
+                            complete(slot->record);
+                        }
+                        catch (...)
+                        {
+                            error = std::current_exception();
+                        }
+                    }
+
+                    if (error != nullptr)
+                        m_stopRequested.store(true, std::memory_order_relaxed);
+                }
+
+                const bool endOfInput { slot->endOfInput };
+                m_freeQueue.push(slot);
+
+                if (endOfInput)
+                    break;
+            }
+
+            // joins the threads
+        }
+
+        if (error != nullptr)
+            std::rethrow_exception(error);
+    }
+};
+
+}
+
+#endif
@@ -16,17 +16,127 @@
 
 #include "output-buffer.h"
 
+#include <algorithm>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace hoover_chess_utils::utils
 {
 
+namespace
+{
+
+// Characters that need special handling in block comment text: whitespace
+// and braces
+struct CommentSpecialChars
+{
+    static inline bool match(unsigned char c) noexcept
+    {
+        return c <= 0x20U || c == '{' || c == '}';
+    }
+
+#if defined(__SSE2__)
+    static inline __m128i match(__m128i v) noexcept
+    {
+        // unsigned v <= 0x20 is equivalent to min(v, 0x20) == v
+        const __m128i whiteSpace { _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x20)), v) };
+        const __m128i openBrace { _mm_cmpeq_epi8(v, _mm_set1_epi8('{')) };
+        const __m128i closeBrace { _mm_cmpeq_epi8(v, _mm_set1_epi8('}')) };
+
+        return _mm_or_si128(whiteSpace, _mm_or_si128(openBrace, closeBrace));
+    }
+#elif defined(__ARM_NEON)
+    static inline uint8x16_t match(uint8x16_t v) noexcept
+    {
+        const uint8x16_t whiteSpace { vcleq_u8(v, vdupq_n_u8(0x20U)) };
+        const uint8x16_t openBrace { vceqq_u8(v, vdupq_n_u8('{')) };
+        const uint8x16_t closeBrace { vceqq_u8(v, vdupq_n_u8('}')) };
+
+        return vorrq_u8(whiteSpace, vorrq_u8(openBrace, closeBrace));
+    }
+#endif
+};
+
+// Characters that need escaping in PGN tag values
+struct EscapeSpecialChars
+{
+    static inline bool match(unsigned char c) noexcept
+    {
+        return c == '"' || c == '\\';
+    }
+
+#if defined(__SSE2__)
+    static inline __m128i match(__m128i v) noexcept
+    {
+        return _mm_or_si128(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+    }
+#elif defined(__ARM_NEON)
+    static inline uint8x16_t match(uint8x16_t v) noexcept
+    {
+        return vorrq_u8(
+            vceqq_u8(v, vdupq_n_u8('"')),
+            vceqq_u8(v, vdupq_n_u8('\\')));
+    }
+#endif
+};
+
+// Returns the first character in [p, end) that matches, or end if there is
+// none. Scans in 16-byte blocks when SIMD is available.
+template <typename T_Matcher>
+inline const char *findSpecialChar(const char *p, const char *end) noexcept
+{
+#if defined(__SSE2__)
+    while (end - p >= 16)
+    {
+        const __m128i v { _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)) };
+        const std::uint32_t mask { static_cast<std::uint32_t>(_mm_movemask_epi8(T_Matcher::match(v))) };
+
+        if (mask != 0U)
+            return p + std::countr_zero(mask);
+
+        p += 16;
+    }
+#elif defined(__ARM_NEON)
+    while (end - p >= 16)
+    {
+        const uint8x16_t v { vld1q_u8(reinterpret_cast<const std::uint8_t *>(p)) };
+
+        // narrow the byte mask into a nibble mask
+        const uint8x8_t narrowed { vshrn_n_u16(vreinterpretq_u16_u8(T_Matcher::match(v)), 4) };
+        const std::uint64_t mask { vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) };
+
+        if (mask != 0U)
+            return p + std::countr_zero(mask) / 4U;
+
+        p += 16;
+    }
+#endif
+
+    while (p != end && !T_Matcher::match(static_cast<unsigned char>(*p)))
+        ++p;
+
+    return p;
+}
+
+}
+
 void OutputBuffer::writeInternal(const char *str, std::size_t numChars)
 {
     while (numChars > 0U)
     {
+        if (m_numChars == ctBufferSize)
+            flush();
+
         const std::size_t writeSize { std::min(ctBufferSize - m_numChars, numChars) };
 
         std::memcpy(&m_buf[m_numChars], str, writeSize);
@@ -35,15 +145,105 @@ void OutputBuffer::writeInternal(const char *str, std::size_t numChars)
 
         numChars -= writeSize;
         str += writeSize;
+    }
+}
+
+void OutputBuffer::writeNormalizedComment(std::string_view sv)
+{
+    const char *in { sv.data() };
+    const char *const inEnd { in + sv.size() };
+    bool eatWhiteSpace { true };
 
+    while (in != inEnd)
+    {
         if (m_numChars == ctBufferSize)
             flush();
+
+        // the output is never longer than the input, so we can transform
+        // directly into the buffer
+        const char *const chunkEnd {
+            in + std::min(static_cast<std::size_t>(inEnd - in), ctBufferSize - m_numChars) };
+        char *out { &m_buf[m_numChars] };
+
+        while (true)
+        {
+            const char *const special { findSpecialChar<CommentSpecialChars>(in, chunkEnd) };
+            const std::size_t runLength { static_cast<std::size_t>(special - in) };
+
+            if (runLength != 0U)
+            {
+                std::memcpy(out, in, runLength);
+                out += runLength;
+                in = special;
+                eatWhiteSpace = false;
+            }
+
+            if (in == chunkEnd)
+                break;
+
+            const unsigned char c { static_cast<unsigned char>(*in++) };
+            if (c <= 0x20U)
+            {
+                if (!eatWhiteSpace)
+                {
+                    *out++ = ' ';
+                    eatWhiteSpace = true;
+                }
+            }
+            else
+            {
+                // map braces to parens
+                *out++ = (c == '{') ? '(' : ')';
+                eatWhiteSpace = false;
+            }
+        }
+
+        m_numChars = static_cast<std::size_t>(out - m_buf.data());
+    }
+}
+
+void OutputBuffer::writeEscapedPgnValue(std::string_view sv)
+{
+    const char *in { sv.data() };
+    const char *const inEnd { in + sv.size() };
+
+    while (in != inEnd)
+    {
+        // escaping at most doubles the length
+        if (ctBufferSize - m_numChars < 2U)
+            flush();
+
+        const char *const chunkEnd {
+            in + std::min(static_cast<std::size_t>(inEnd - in), (ctBufferSize - m_numChars) / 2U) };
+        char *out { &m_buf[m_numChars] };
+
+        while (true)
+        {
+            const char *const special { findSpecialChar<EscapeSpecialChars>(in, chunkEnd) };
+            const std::size_t runLength { static_cast<std::size_t>(special - in) };
+
+            std::memcpy(out, in, runLength);
+            out += runLength;
+            in = special;
+
+            if (in == chunkEnd)
+                break;
+
+            *out++ = '\\';
+            *out++ = *in++;
+        }
+
+        m_numChars = static_cast<std::size_t>(out - m_buf.data());
     }
 }
 
 void OutputBuffer::flush()
 {
-    std::fwrite(m_buf.data(), m_numChars, 1U, stdout);
+    if (m_target != nullptr)
+        m_target->append(m_buf.data(), m_numChars);
+    else
+        std::fwrite(m_buf.data(), m_numChars, 1U, stdout);
+
     m_numChars = 0U;
 }
 
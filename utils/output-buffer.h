@@ -19,8 +19,12 @@
 
 #include "pgnreader-string-utils.h"
 
+#include <array>
+#include <cassert>
 #include <cstddef>
 #include <cstring>
+#include <string>
+#include <string_view>
 
 namespace hoover_chess_utils::utils
 {
@@ -30,12 +34,33 @@ class OutputBuffer
 private:
     static constexpr std::size_t ctBufferSize { 65536U };
 
+public:
+    static constexpr std::size_t ctMaxReserve { 4096U };
+
+private:
+
     std::size_t m_numChars { };
     std::array<char, ctBufferSize> m_buf;
 
+    // flush target. stdout when nullptr.
+    std::string *m_target { };
+
     void writeInternal(const char *str, std::size_t numChars);
 
 public:
+    // Buffers output to stdout
+    OutputBuffer() = default;
+
+    // Buffers output to a string. Flushing appends to the string.
+    explicit OutputBuffer(std::string &target) :
+        m_target { &target }
+    {
+    }
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer(OutputBuffer &&) = delete;
+    OutputBuffer &operator = (const OutputBuffer &) & = delete;
+    OutputBuffer &operator = (OutputBuffer &&) & = delete;
 
     ~OutputBuffer() noexcept
     {
@@ -56,14 +81,55 @@ public:
     template <std::size_t t_maxSize>
     inline void write(const pgn_reader::MiniString<t_maxSize> &s)
     {
-        writeInternal(s.data(), s.size());
+        char *const p { reserve(t_maxSize) };
+        std::memcpy(p, s.data(), s.size());
+        commit(s.size());
     }
 
     inline void write(char c)
     {
-        writeInternal(&c, 1U);
+        *reserve(1U) = c;
+        commit(1U);
     }
 
+    // Reserves space for up to numChars characters and returns the write
+    // pointer. The buffer is flushed first if there is not enough
+    // space. Complete the write with commit(). The maximum reservation is
+    // ctMaxReserve characters.
+    inline char *reserve(std::size_t numChars)
+    {
+        assert(numChars <= ctMaxReserve);
+
+        if (ctBufferSize - m_numChars < numChars) [[unlikely]]
+            flush();
+
+        return &m_buf[m_numChars];
+    }
+
+    // Commits numChars characters written after reserve(). numChars must not
+    // exceed the reservation.
+    inline void commit(std::size_t numChars) noexcept
+    {
+        m_numChars += numChars;
+    }
+
+    // Copies a string to a write pointer obtained with reserve(). Returns the
+    // write pointer past the copied string.
+    static inline char *put(char *p, std::string_view sv) noexcept
+    {
+        std::memcpy(p, sv.data(), sv.size());
+        return p + sv.size();
+    }
+
+    // Writes the text for a PGN block comment. Leading whitespace is
+    // dropped, whitespace runs are collapsed into a single space, and braces
+    // are mapped to parentheses, since braces can't appear in block
+    // comments. Whitespace is any character in range [0x00, 0x20].
+    void writeNormalizedComment(std::string_view sv);
+
+    // Writes a PGN tag value with quotes and backslashes escaped.
+    void writeEscapedPgnValue(std::string_view sv);
+
     void flush();
 };
 
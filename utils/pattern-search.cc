@@ -0,0 +1,242 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "memory-mapped-file.h"
+#include "pgn-segments.h"
+#include "position-pattern.h"
+#include "process-in-order.h"
+#include "to-number.h"
+
+#include "chessboard.h"
+#include "pgnreader.h"
+#include "pgnreader-string-utils.h"
+#include "version.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace hoover_chess_utils::utils
+{
+
+namespace
+{
+
+void printHelp()
+{
+    std::cout << "TCEC games database pattern search tool (" << hoover_chess_utils::pgn_reader::getVersionString() << ')' << std::endl;
+    std::cout << std::endl;
+    std::cout << "Usage: hoover-pattern-search <PGN-database> <pattern> [threads]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Reports the games that reach a position matching the pattern. The pattern" << std::endl;
+    std::cout << "consists of whitespace-separated terms, which must all match:" << std::endl;
+    std::cout << std::endl;
+    std::cout << "KRPvKR   Exact material. White pieces before 'v', black pieces after." << std::endl;
+    std::cout << "Nd5      White knight on d5. Upper case for white, lower case for black." << std::endl;
+    std::cout << "!pd6     No black pawn on d6" << std::endl;
+    std::cout << "w, b     Side to move" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Example: hoover-pattern-search tcec.pgn \"Nd5 pd6 w\"" << std::endl;
+}
+
+struct PatternMatch
+{
+    std::string whitePlayer;
+    std::string blackPlayer;
+    std::string result;
+    std::string site;
+
+    // first matching position
+    std::uint32_t plyNum;
+};
+
+class PatternSearchActions : public pgn_reader::PgnReaderActions
+{
+private:
+    const PositionPattern &m_pattern;
+    std::vector<PatternMatch> &m_matches;
+
+    const pgn_reader::ChessBoard *m_board { };
+
+    PatternMatch m_currentGame { };
+    bool m_matched { };
+    std::size_t m_numGames { };
+
+    void checkCurrentBoard()
+    {
+        if (!m_matched && m_pattern.matches(*m_board)) [[unlikely]]
+        {
+            m_matched = true;
+            m_currentGame.plyNum = m_board->getCurrentPlyNum();
+        }
+    }
+
+public:
+    PatternSearchActions(const PositionPattern &pattern, std::vector<PatternMatch> &matches) noexcept :
+        m_pattern { pattern },
+        m_matches { matches }
+    {
+    }
+
+    void setBoardReferences(
+        const pgn_reader::ChessBoard &curBoard,
+        const pgn_reader::ChessBoard &prevBoard) override
+    {
+        m_board = &curBoard;
+        static_cast<void>(prevBoard);
+    }
+
+    void gameStart() override
+    {
+        m_currentGame.whitePlayer.clear();
+        m_currentGame.blackPlayer.clear();
+        m_currentGame.result.clear();
+        m_currentGame.site.clear();
+        m_matched = false;
+    }
+
+    void pgnTag(std::string_view key, std::string_view value) override
+    {
+        if (key == "White")
+            m_currentGame.whitePlayer = value;
+        else if (key == "Black")
+            m_currentGame.blackPlayer = value;
+        else if (key == "Result")
+            m_currentGame.result = value;
+        else if (key == "Site")
+            m_currentGame.site = value;
+    }
+
+    void moveTextSection() override
+    {
+        checkCurrentBoard();
+    }
+
+    void afterMove(pgn_reader::Move) override
+    {
+        checkCurrentBoard();
+    }
+
+    void gameTerminated(pgn_reader::PgnResult) override
+    {
+        ++m_numGames;
+
+        if (m_matched)
+            m_matches.push_back(m_currentGame);
+    }
+
+    std::size_t getNumGames() const noexcept
+    {
+        return m_numGames;
+    }
+};
+
+int patternSearchMain(int argc, char **argv) noexcept
+{
+    if (argc != 3 && argc != 4)
+    {
+        printHelp();
+        return 127;
+    }
+
+    try
+    {
+        std::size_t numThreads { std::max<std::size_t>(std::thread::hardware_concurrency(), 1U) };
+
+        if (argc == 4)
+            numThreads = std::clamp(toNumber<std::size_t>(argv[3]), std::size_t { 1U }, std::size_t { 256U });
+
+        const PositionPattern pattern { PositionPattern::compile(argv[2]) };
+
+        MemoryMappedFile mmfile { };
+        mmfile.map(argv[1], true, false);
+
+        const std::string_view databasePgn { mmfile.getStringView() };
+
+        std::vector<std::string_view> segments { };
+        splitIntoSegments(databasePgn, targetSegmentSizeForThreads(databasePgn.size(), numThreads), segments);
+
+        std::vector<std::vector<PatternMatch> > segmentMatches(segments.size());
+        std::vector<std::size_t> segmentNumGames(segments.size());
+        std::size_t numGames { };
+        std::size_t numMatches { };
+
+        // matches are printed in the database order
+        processInOrder(
+            segments.size(), numThreads,
+            [&](std::size_t i)
+            {
+                PatternSearchActions actions { pattern, segmentMatches[i] };
+
+                pgn_reader::PgnReader::readFromMemory(
+                    segments[i],
+                    actions,
+                    pgn_reader::PgnReaderActionFilter {
+                        pgn_reader::PgnReaderActionClass::PgnTag, pgn_reader::PgnReaderActionClass::Move });
+
+                segmentNumGames[i] = actions.getNumGames();
+            },
+            [&](std::size_t i)
+            {
+                for (const PatternMatch &match : segmentMatches[i])
+                {
+                    std::cout
+                        << std::format("{} - {} ({}) {} first match at {}",
+                                       match.whitePlayer, match.blackPlayer, match.result, match.site,
+                                       pgn_reader::StringUtils::plyNumToString(match.plyNum).getStringView())
+                        << std::endl;
+                }
+
+                numGames += segmentNumGames[i];
+                numMatches += segmentMatches[i].size();
+
+                std::vector<PatternMatch> { }.swap(segmentMatches[i]);
+            });
+
+        std::cout << std::format("Matching games: {} of {}", numMatches, numGames) << std::endl;
+
+        mmfile.unmap();
+
+        return 0;
+    }
+    catch (const pgn_reader::PgnError &pgnError)
+    {
+        std::cerr << pgnError.what() << std::endl;
+
+        return 1;
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+
+        return 2;
+    }
+}
+
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    return hoover_chess_utils::utils::patternSearchMain(argc, argv);
+}
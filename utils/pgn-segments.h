@@ -0,0 +1,112 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__PGN_SEGMENTS_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__PGN_SEGMENTS_H_INCLUDED
+
+#include "memory-mapped-file.h"
+
+#include "pgnreader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace hoover_chess_utils::utils
+{
+
+// Finds the next game start at or after pos. Returns pgn.size() if there is
+// none. A game start is a plausible game start for the PGN reader (see
+// PgnReader::findNextGameStart()) whose line is a tag pair, e.g.,
+// [Event "x"]. The latter check rejects most lines in multi-line comments.
+inline std::size_t findNextGameStart(std::string_view pgn, std::size_t pos) noexcept
+{
+    const auto isTagPairStart {
+        [pgn](std::size_t tagStart) noexcept
+        {
+            // '[', tag key, whitespace, '"'
+            std::size_t i { tagStart + 1U };
+
+            while (i < pgn.size() &&
+                   ((pgn[i] >= 'A' && pgn[i] <= 'Z') || (pgn[i] >= 'a' && pgn[i] <= 'z') ||
+                    (pgn[i] >= '0' && pgn[i] <= '9') || pgn[i] == '_'))
+            {
+                ++i;
+            }
+
+            if (i == tagStart + 1U)
+                return false;
+
+            while (i < pgn.size() && (pgn[i] == ' ' || pgn[i] == '\t'))
+                ++i;
+
+            return i < pgn.size() && pgn[i] == '"';
+        } };
+
+    while (true)
+    {
+        pos = pgn_reader::PgnReader::findNextGameStart(pgn, pos);
+
+        if (pos == pgn.size() || isTagPairStart(pos))
+            return pos;
+
+        ++pos;
+    }
+}
+
+// Splits a PGN into game-aligned segments of at least targetSegmentSize bytes
+// (except the last one) and appends them to segments
+inline void splitIntoSegments(
+    std::string_view pgn, std::size_t targetSegmentSize, std::vector<std::string_view> &segments)
+{
+    std::size_t segmentBegin { };
+
+    while (segmentBegin < pgn.size())
+    {
+        std::size_t segmentEnd { pgn.size() };
+
+        if (pgn.size() - segmentBegin > targetSegmentSize)
+            segmentEnd = findNextGameStart(pgn, segmentBegin + targetSegmentSize);
+
+        segments.push_back(pgn.substr(segmentBegin, segmentEnd - segmentBegin));
+        segmentBegin = segmentEnd;
+    }
+}
+
+// Splits PGN files into game-aligned segments, in the input order
+inline std::vector<std::string_view> splitIntoSegments(
+    const std::vector<MemoryMappedFile> &files, std::size_t targetSegmentSize)
+{
+    std::vector<std::string_view> segments { };
+
+    for (const MemoryMappedFile &file : files)
+        splitIntoSegments(file.getStringView(), targetSegmentSize, segments);
+
+    return segments;
+}
+
+// Target segment size for splitting totalSize bytes of PGN for numThreads
+// threads. Several segments per thread for load balancing, but at least 1 MiB
+// per segment.
+inline std::size_t targetSegmentSizeForThreads(std::size_t totalSize, std::size_t numThreads) noexcept
+{
+    return std::max<std::size_t>(totalSize / (numThreads * 16U), 1U << 20U);
+}
+
+}
+
+#endif
@@ -0,0 +1,655 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "memory-mapped-file.h"
+#include "pgn-segments.h"
+#include "position-fingerprint.h"
+#include "to-number.h"
+
+#include "chessboard.h"
+#include "pgnreader.h"
+#include "pgnreader-string-utils.h"
+#include "position-compress-fixed.h"
+#include "version.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace hoover_chess_utils::utils
+{
+
+namespace
+{
+
+void printHelp()
+{
+    std::cout << "Unique position census tool (" << hoover_chess_utils::pgn_reader::getVersionString() << ')' << std::endl;
+    std::cout << std::endl;
+    std::cout << "Usage: hoover-position-census [options] <PGN-file>..." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "--threads <n>       Number of threads (default: hardware threads)" << std::endl;
+    std::cout << "--top <k>           Number of most frequent positions to report (default: 20)" << std::endl;
+    std::cout << "--memory <MiB>      Memory budget for the position table (default: 2048)" << std::endl;
+    std::cout << "--after-book-exit   Count only the positions from the book exit onward" << std::endl;
+}
+
+// Concurrent open-addressing hash table of position fingerprints and game
+// counts. Threads insert with compare-and-swap on the key and increment the
+// counts atomically, so no locking is needed. Fingerprint 0 marks an empty
+// slot. An entry takes 12 bytes, and the table does not grow: when the
+// memory budget is exceeded, the census fails.
+class FingerprintCountTable
+{
+public:
+    static constexpr std::size_t ctBytesPerSlot { sizeof(std::uint64_t) + sizeof(std::uint32_t) };
+
+private:
+    std::unique_ptr<std::atomic<std::uint64_t>[]> m_keys { };
+    std::unique_ptr<std::atomic<std::uint32_t>[]> m_counts { };
+    std::size_t m_numSlots { };
+    std::size_t m_maxEntries { };
+    std::atomic<std::size_t> m_numEntries { };
+
+public:
+    explicit FingerprintCountTable(std::size_t memoryBudget) :
+        m_numSlots { std::bit_floor(std::max<std::size_t>(memoryBudget / ctBytesPerSlot, 1U << 20U)) },
+
+        // keep the probe sequences short
+        m_maxEntries { m_numSlots / 8U * 7U }
+    {
+        m_keys = std::make_unique<std::atomic<std::uint64_t>[]>(m_numSlots);
+        m_counts = std::make_unique<std::atomic<std::uint32_t>[]>(m_numSlots);
+    }
+
+    // Increments the count of a fingerprint. Returns true if the fingerprint
+    // was inserted in the table.
+    bool increment(std::uint64_t fingerprint) noexcept
+    {
+        if (fingerprint == 0U) [[unlikely]]
+            fingerprint = 1U;
+
+        const std::size_t mask { m_numSlots - 1U };
+        std::size_t slot { fingerprint & mask };
+
+        while (true)
+        {
+            std::uint64_t key { m_keys[slot].load(std::memory_order_relaxed) };
+
+            if (key == 0U)
+            {
+                if (m_keys[slot].compare_exchange_strong(key, fingerprint, std::memory_order_relaxed))
+                {
+                    m_counts[slot].fetch_add(1U, std::memory_order_relaxed);
+                    return true;
+                }
+
+                // key has the fingerprint inserted by another thread
+            }
+
+            if (key == fingerprint)
+            {
+                m_counts[slot].fetch_add(1U, std::memory_order_relaxed);
+                return false;
+            }
+
+            slot = (slot + 1U) & mask;
+        }
+    }
+
+    // Accounts for entries inserted by a thread. The threads report the
+    // inserted entries in batches to avoid contention on the entry counter.
+    void addEntries(std::size_t numEntries)
+    {
+        const std::size_t total { m_numEntries.fetch_add(numEntries, std::memory_order_relaxed) + numEntries };
+
+        if (total > m_maxEntries)
+        {
+            throw std::runtime_error(
+                std::format("Position table is full ({} entries). Increase the memory budget with --memory",
+                            m_maxEntries));
+        }
+    }
+
+    std::size_t getNumEntries() const noexcept
+    {
+        return m_numEntries.load(std::memory_order_relaxed);
+    }
+
+    std::size_t getNumSlots() const noexcept
+    {
+        return m_numSlots;
+    }
+
+    std::pair<std::uint64_t, std::uint32_t> getSlot(std::size_t slot) const noexcept
+    {
+        return {
+            m_keys[slot].load(std::memory_order_relaxed),
+            m_counts[slot].load(std::memory_order_relaxed) };
+    }
+};
+
+class CensusActions : public pgn_reader::PgnReaderActions
+{
+private:
+    // entries are reported to the table in batches of this size. With 256
+    // threads, the table may exceed the entry limit by 64Ki entries at most,
+    // which still leaves free slots in the minimum-sized table.
+    static constexpr std::size_t ctEntryBatchSize { 256U };
+
+    FingerprintCountTable &m_table;
+    const bool m_afterBookExit;
+
+    const pgn_reader::ChessBoard *m_board { };
+
+    std::vector<std::uint64_t> m_gameFingerprints { };
+    std::size_t m_bookEnd { };
+
+    std::size_t m_numGames { };
+    std::size_t m_numPositions { };
+    std::size_t m_numUnreportedEntries { };
+
+    void addCurrentBoard()
+    {
+        pgn_reader::CompressedPosition_FixedLength cp;
+        pgn_reader::PositionCompressor_FixedLength::compress(*m_board, cp);
+
+        m_gameFingerprints.push_back(positionFingerprint(cp));
+    }
+
+public:
+    CensusActions(FingerprintCountTable &table, bool afterBookExit) noexcept :
+        m_table { table },
+        m_afterBookExit { afterBookExit }
+    {
+    }
+
+    void setBoardReferences(
+        const pgn_reader::ChessBoard &curBoard,
+        const pgn_reader::ChessBoard &prevBoard) override
+    {
+        m_board = &curBoard;
+        static_cast<void>(prevBoard);
+    }
+
+    void gameStart() override
+    {
+        m_gameFingerprints.clear();
+        m_bookEnd = 0U;
+    }
+
+    void moveTextSection() override
+    {
+        addCurrentBoard();
+    }
+
+    void afterMove(pgn_reader::Move) override
+    {
+        addCurrentBoard();
+    }
+
+    void comment(std::string_view comment) override
+    {
+        // the book exit position is not a book position, since the next move
+        // is decided by the engines
+        if (comment == "Book exit" && !m_gameFingerprints.empty())
+            m_bookEnd = m_gameFingerprints.size() - 1U;
+    }
+
+    void gameTerminated(pgn_reader::PgnResult) override
+    {
+        auto begin { m_gameFingerprints.begin() };
+        if (m_afterBookExit)
+            begin += m_bookEnd;
+
+        // count positions once per game
+        std::sort(begin, m_gameFingerprints.end());
+        const auto end { std::unique(begin, m_gameFingerprints.end()) };
+
+        for (auto i { begin }; i != end; ++i)
+        {
+            if (m_table.increment(*i) && ++m_numUnreportedEntries >= ctEntryBatchSize)
+                flushEntries();
+        }
+
+        ++m_numGames;
+        m_numPositions += end - begin;
+    }
+
+    void flushEntries()
+    {
+        m_table.addEntries(m_numUnreportedEntries);
+        m_numUnreportedEntries = 0U;
+    }
+
+    std::size_t getNumGames() const noexcept
+    {
+        return m_numGames;
+    }
+
+    std::size_t getNumPositions() const noexcept
+    {
+        return m_numPositions;
+    }
+};
+
+// Resolves the positions of the given fingerprints
+class ResolvePositionsActions : public pgn_reader::PgnReaderActions
+{
+private:
+    const std::vector<std::uint64_t> &m_fingerprints;
+    std::vector<pgn_reader::CompressedPosition_FixedLength> &m_positions;
+    std::vector<std::atomic<bool> > &m_resolved;
+    std::atomic<std::size_t> &m_numUnresolved;
+
+    const pgn_reader::ChessBoard *m_board { };
+
+    void checkCurrentBoard()
+    {
+        pgn_reader::CompressedPosition_FixedLength cp;
+        pgn_reader::PositionCompressor_FixedLength::compress(*m_board, cp);
+
+        std::uint64_t fingerprint { positionFingerprint(cp) };
+        if (fingerprint == 0U) [[unlikely]]
+            fingerprint = 1U;
+
+        const auto i { std::lower_bound(m_fingerprints.begin(), m_fingerprints.end(), fingerprint) };
+
+        if (i != m_fingerprints.end() && *i == fingerprint) [[unlikely]]
+        {
+            const std::size_t index = i - m_fingerprints.begin();
+
+            if (!m_resolved[index].exchange(true, std::memory_order_relaxed))
+            {
+                m_positions[index] = cp;
+                m_numUnresolved.fetch_sub(1U, std::memory_order_relaxed);
+            }
+        }
+    }
+
+public:
+    ResolvePositionsActions(
+        const std::vector<std::uint64_t> &fingerprints,
+        std::vector<pgn_reader::CompressedPosition_FixedLength> &positions,
+        std::vector<std::atomic<bool> > &resolved,
+        std::atomic<std::size_t> &numUnresolved) noexcept :
+        m_fingerprints { fingerprints },
+        m_positions { positions },
+        m_resolved { resolved },
+        m_numUnresolved { numUnresolved }
+    {
+    }
+
+    void setBoardReferences(
+        const pgn_reader::ChessBoard &curBoard,
+        const pgn_reader::ChessBoard &prevBoard) override
+    {
+        m_board = &curBoard;
+        static_cast<void>(prevBoard);
+    }
+
+    void moveTextSection() override
+    {
+        checkCurrentBoard();
+    }
+
+    void afterMove(pgn_reader::Move) override
+    {
+        checkCurrentBoard();
+    }
+};
+
+// Runs threadFn(segment) for every segment in numThreads threads. The threads
+// stop picking up new segments when stopFn() returns true.
+void forEachSegment(
+    const std::vector<std::string_view> &segments, std::size_t numThreads,
+    const std::function<void(std::size_t thread, std::string_view segment)> &threadFn,
+    const std::function<bool()> &stopFn)
+{
+    std::atomic<std::size_t> nextSegment { };
+    std::vector<std::exception_ptr> errors(numThreads);
+
+    {
+        std::vector<std::jthread> threads { };
+
+        for (std::size_t t { }; t < numThreads; ++t)
+        {
+            threads.emplace_back(
+                [&, t]() noexcept
+                {
+                    try
+                    {
+                        while (!stopFn())
+                        {
+                            const std::size_t i { nextSegment.fetch_add(1U, std::memory_order_relaxed) };
+                            if (i >= segments.size())
+                                break;
+
+                            threadFn(t, segments[i]);
+                        }
+                    }
+                    catch (...)
+                    {
+                        errors[t] = std::current_exception();
+
+                        // stop the other threads, too
+                        nextSegment.store(segments.size(), std::memory_order_relaxed);
+                    }
+                });
+        }
+
+        // joins the threads
+    }
+
+    for (const std::exception_ptr &error : errors)
+    {
+        if (error != nullptr)
+            std::rethrow_exception(error);
+    }
+}
+
+struct CensusResult
+{
+    std::size_t numGames;
+    std::size_t numPositions;
+    std::size_t numDistinctPositions;
+
+    // index i: number of positions seen in [2^(i-1), 2^i - 1] games
+    std::array<std::size_t, 33U> histogram;
+
+    // most frequent positions, in descending order of counts
+    std::vector<std::pair<std::uint32_t, std::uint64_t> > topPositions;
+};
+
+void collectTopPositions(
+    const FingerprintCountTable &table, std::size_t topK, std::size_t numThreads, CensusResult &result)
+{
+    using CountAndFingerprint = std::pair<std::uint32_t, std::uint64_t>;
+
+    // min-heaps of the top-K candidates and the histograms of the table slices
+    std::vector<std::vector<CountAndFingerprint> > topHeaps(numThreads);
+    std::vector<std::array<std::size_t, 33U> > histograms(numThreads);
+
+    {
+        std::vector<std::jthread> threads { };
+
+        for (std::size_t t { }; t < numThreads; ++t)
+        {
+            threads.emplace_back(
+                [&, t]() noexcept
+                {
+                    std::vector<CountAndFingerprint> &heap { topHeaps[t] };
+                    std::array<std::size_t, 33U> &histogram { histograms[t] };
+
+                    histogram.fill(0U);
+
+                    const std::size_t sliceBegin { table.getNumSlots() * t / numThreads };
+                    const std::size_t sliceEnd { table.getNumSlots() * (t + 1U) / numThreads };
+
+                    for (std::size_t slot { sliceBegin }; slot < sliceEnd; ++slot)
+                    {
+                        const auto [fingerprint, count] { table.getSlot(slot) };
+
+                        if (fingerprint == 0U)
+                            continue;
+
+                        const CountAndFingerprint entry { count, fingerprint };
+
+                        ++histogram[std::bit_width(count)];
+
+                        if (heap.size() < topK)
+                        {
+                            heap.push_back(entry);
+                            std::push_heap(heap.begin(), heap.end(), std::greater<> { });
+                        }
+                        else if (topK != 0U && entry > heap.front())
+                        {
+                            std::pop_heap(heap.begin(), heap.end(), std::greater<> { });
+                            heap.back() = entry;
+                            std::push_heap(heap.begin(), heap.end(), std::greater<> { });
+                        }
+                    }
+                });
+        }
+
+        // joins the threads
+    }
+
+    result.histogram.fill(0U);
+    result.topPositions.clear();
+
+    for (std::size_t t { }; t < numThreads; ++t)
+    {
+        for (std::size_t i { }; i < result.histogram.size(); ++i)
+            result.histogram[i] += histograms[t][i];
+
+        result.topPositions.insert(result.topPositions.end(), topHeaps[t].begin(), topHeaps[t].end());
+    }
+
+    std::sort(result.topPositions.begin(), result.topPositions.end(), std::greater<> { });
+    result.topPositions.resize(std::min(result.topPositions.size(), topK));
+}
+
+std::vector<pgn_reader::CompressedPosition_FixedLength> resolveTopPositions(
+    const std::vector<std::string_view> &segments, std::size_t numThreads, const CensusResult &result)
+{
+    std::vector<std::uint64_t> fingerprints { };
+    for (const auto &[count, fingerprint] : result.topPositions)
+        fingerprints.push_back(fingerprint);
+
+    std::sort(fingerprints.begin(), fingerprints.end());
+
+    std::vector<pgn_reader::CompressedPosition_FixedLength> positions(fingerprints.size());
+    std::vector<std::atomic<bool> > resolved(fingerprints.size());
+    std::atomic<std::size_t> numUnresolved { fingerprints.size() };
+
+    forEachSegment(
+        segments, numThreads,
+        [&](std::size_t, std::string_view segment)
+        {
+            ResolvePositionsActions actions { fingerprints, positions, resolved, numUnresolved };
+
+            pgn_reader::PgnReader::readFromMemory(
+                segment,
+                actions,
+                pgn_reader::PgnReaderActionFilter { pgn_reader::PgnReaderActionClass::Move });
+        },
+        [&]() noexcept
+        {
+            return numUnresolved.load(std::memory_order_relaxed) == 0U;
+        });
+
+    // back to the order of the top positions
+    std::vector<pgn_reader::CompressedPosition_FixedLength> ret { };
+    for (const auto &[count, fingerprint] : result.topPositions)
+    {
+        const std::size_t index = std::lower_bound(fingerprints.begin(), fingerprints.end(), fingerprint) - fingerprints.begin();
+        ret.push_back(positions[index]);
+    }
+
+    return ret;
+}
+
+void printResult(const CensusResult &result, const std::vector<pgn_reader::CompressedPosition_FixedLength> &topPositions)
+{
+    std::cout << std::format("Games:              {}", result.numGames) << std::endl;
+    std::cout << std::format("Positions:          {}", result.numPositions) << std::endl;
+    std::cout << std::format("Distinct positions: {}", result.numDistinctPositions) << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "Distinct positions by number of games:" << std::endl;
+    for (std::size_t i { 1U }; i < result.histogram.size(); ++i)
+    {
+        if (result.histogram[i] == 0U)
+            continue;
+
+        const std::uint64_t low { std::uint64_t { 1U } << (i - 1U) };
+        const std::uint64_t high { (std::uint64_t { 1U } << i) - 1U };
+
+        if (low == high)
+            std::cout << std::format("  {:>21}: {}", low, result.histogram[i]) << std::endl;
+        else
+            std::cout << std::format("  {:>21}: {}", std::format("{}-{}", low, high), result.histogram[i]) << std::endl;
+    }
+
+    if (topPositions.empty())
+        return;
+
+    std::cout << std::endl;
+    std::cout << "Most frequent positions (games, FEN):" << std::endl;
+
+    pgn_reader::ChessBoard board { };
+    pgn_reader::FenString fen { pgn_reader::MiniString_Uninitialized { } };
+
+    for (std::size_t i { }; i < topPositions.size(); ++i)
+    {
+        pgn_reader::PositionCompressor_FixedLength::decompress(topPositions[i], 0U, 1U, board);
+        pgn_reader::StringUtils::boardToFEN(board, fen);
+
+        std::cout << std::format("{:>5}. {:>10} {}", i + 1U, result.topPositions[i].first, fen.getStringView()) << std::endl;
+    }
+}
+
+int positionCensusMain(int argc, char **argv) noexcept
+{
+    try
+    {
+        std::size_t numThreads { std::max<std::size_t>(std::thread::hardware_concurrency(), 1U) };
+        std::size_t topK { 20U };
+        std::size_t memoryBudgetMiB { 2048U };
+        bool afterBookExit { false };
+        std::vector<MemoryMappedFile> files { };
+
+        int argi { 1 };
+        for (; argi < argc; ++argi)
+        {
+            const std::string_view arg { argv[argi] };
+
+            if (arg == "--after-book-exit")
+                afterBookExit = true;
+            else if ((arg == "--threads" || arg == "--top" || arg == "--memory") && argi + 1 < argc)
+            {
+                const std::string_view value { argv[++argi] };
+
+                if (arg == "--threads")
+                    numThreads = std::clamp(toNumber<std::size_t>(value), std::size_t { 1U }, std::size_t { 256U });
+                else if (arg == "--top")
+                    topK = toNumber<std::size_t>(value);
+                else
+                    memoryBudgetMiB = toNumber<std::size_t>(value);
+            }
+            else if (arg.starts_with("--"))
+            {
+                printHelp();
+                return 127;
+            }
+            else
+                break;
+        }
+
+        if (argi == argc)
+        {
+            printHelp();
+            return 127;
+        }
+
+        files.resize(argc - argi);
+        for (std::size_t i { }; i < files.size(); ++i)
+            files[i].map(argv[argi + i], true, false);
+
+        std::size_t totalSize { };
+        for (const MemoryMappedFile &file : files)
+            totalSize += file.size();
+
+        const std::vector<std::string_view> segments {
+            splitIntoSegments(files, targetSegmentSizeForThreads(totalSize, numThreads)) };
+
+        FingerprintCountTable table { memoryBudgetMiB << 20U };
+        std::vector<CensusActions> actions { };
+        actions.reserve(numThreads);
+
+        for (std::size_t t { }; t < numThreads; ++t)
+            actions.emplace_back(table, afterBookExit);
+
+        forEachSegment(
+            segments, numThreads,
+            [&](std::size_t t, std::string_view segment)
+            {
+                pgn_reader::PgnReader::readFromMemory(
+                    segment,
+                    actions[t],
+                    pgn_reader::PgnReaderActionFilter {
+                        pgn_reader::PgnReaderActionClass::Move, pgn_reader::PgnReaderActionClass::Comment });
+            },
+            []() noexcept
+            {
+                return false;
+            });
+
+        CensusResult result { };
+
+        for (CensusActions &threadActions : actions)
+        {
+            threadActions.flushEntries();
+
+            result.numGames += threadActions.getNumGames();
+            result.numPositions += threadActions.getNumPositions();
+        }
+
+        result.numDistinctPositions = table.getNumEntries();
+
+        collectTopPositions(table, topK, numThreads, result);
+
+        printResult(result, resolveTopPositions(segments, numThreads, result));
+
+        return 0;
+    }
+    catch (const pgn_reader::PgnError &pgnError)
+    {
+        std::cerr << pgnError.what() << std::endl;
+
+        return 1;
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+
+        return 2;
+    }
+}
+
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    return hoover_chess_utils::utils::positionCensusMain(argc, argv);
+}
@@ -0,0 +1,54 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__POSITION_FINGERPRINT_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__POSITION_FINGERPRINT_H_INCLUDED
+
+#include "position-compress-fixed.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+namespace hoover_chess_utils::utils
+{
+
+// 64-bit fingerprint of a compressed position. Different positions may have
+// the same fingerprint, but with hundreds of millions of positions, the
+// probability of a collision stays well below 1%.
+inline std::uint64_t positionFingerprint(const pgn_reader::CompressedPosition_FixedLength &cp) noexcept
+{
+    std::array<std::uint64_t, 3U> words;
+    static_assert(sizeof words == sizeof cp);
+    std::memcpy(words.data(), &cp, sizeof words);
+
+    std::uint64_t h {
+        (words[0U] * UINT64_C(0x9E3779B97F4A7C15)) ^
+        std::rotl(words[1U] * UINT64_C(0xC2B2AE3D27D4EB4F), 21) ^
+        std::rotl(words[2U] * UINT64_C(0x165667B19E3779F9), 42) };
+
+    // final avalanche
+    h ^= h >> 32U;
+    h *= UINT64_C(0xD6E8FEB86659FD93);
+    h ^= h >> 32U;
+
+    return h;
+}
+
+}
+
+#endif
@@ -0,0 +1,121 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "position-pattern.h"
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <stdexcept>
+
+namespace hoover_chess_utils::utils
+{
+
+namespace
+{
+
+// Returns the piece set index of a piece letter, or 12 if the letter is not a
+// piece.
+std::size_t pieceSetIndex(char c) noexcept
+{
+    constexpr std::string_view pieceLetters { "PNBRQKpnbrqk" };
+    return std::min(pieceLetters.find(c), pieceLetters.size());
+}
+
+}
+
+PositionPattern PositionPattern::compile(std::string_view pattern)
+{
+    PositionPattern ret { };
+
+    while (true)
+    {
+        // next term
+        const std::size_t termBegin { std::min(pattern.find_first_not_of(" \t"), pattern.size()) };
+        pattern.remove_prefix(termBegin);
+
+        if (pattern.empty())
+            break;
+
+        const std::string_view term { pattern.substr(0U, std::min(pattern.find_first_of(" \t"), pattern.size())) };
+        pattern.remove_prefix(term.size());
+
+        if (term == "w" || term == "b")
+        {
+            ret.m_turn = static_cast<std::uint64_t>(term == "w" ? pgn_reader::Color::WHITE : pgn_reader::Color::BLACK);
+            ret.m_turnMask = ~std::uint64_t { };
+        }
+        else if (term.find('v') != std::string_view::npos)
+        {
+            // material signature
+            const std::size_t separator { term.find('v') };
+
+            ret.m_counts.fill(0U);
+            ret.m_countMask = ~std::uint64_t { };
+
+            for (std::size_t i { }; i < term.size(); ++i)
+            {
+                if (i == separator)
+                    continue;
+
+                const char upper { static_cast<char>(std::toupper(static_cast<unsigned char>(term[i]))) };
+                const std::size_t index { pieceSetIndex(upper) };
+
+                if (upper != term[i] || index >= 6U)
+                    throw std::invalid_argument(std::format("Bad material signature '{}'", term));
+
+                ++ret.m_counts[index + (i > separator ? 6U : 0U)];
+            }
+
+            // kings are implicit, but at most one per side may be given
+            if (ret.m_counts[5U] > 1U || ret.m_counts[11U] > 1U)
+                throw std::invalid_argument(std::format("Bad material signature '{}'", term));
+
+            ret.m_counts[5U] = 1U;
+            ret.m_counts[11U] = 1U;
+        }
+        else
+        {
+            // piece on square
+            const bool forbidden { term.front() == '!' };
+            const std::string_view pieceSquare { term.substr(forbidden ? 1U : 0U) };
+
+            if (pieceSquare.size() != 3U || pieceSetIndex(pieceSquare[0U]) >= ctNumPieceSets ||
+                pieceSquare[1U] < 'a' || pieceSquare[1U] > 'h' ||
+                pieceSquare[2U] < '1' || pieceSquare[2U] > '8')
+            {
+                throw std::invalid_argument(std::format("Bad pattern term '{}'", term));
+            }
+
+            const std::size_t index { pieceSetIndex(pieceSquare[0U]) };
+            const std::uint64_t squareMask {
+                static_cast<std::uint64_t>(
+                    pgn_reader::SquareSet::square(
+                        pgn_reader::makeSquare(
+                            static_cast<pgn_reader::RowColumn>(pieceSquare[1U] - 'a'),
+                            static_cast<pgn_reader::RowColumn>(pieceSquare[2U] - '1')))) };
+
+            if (forbidden)
+                ret.m_forbidden[index] |= squareMask;
+            else
+                ret.m_required[index] |= squareMask;
+        }
+    }
+
+    return ret;
+}
+
+}
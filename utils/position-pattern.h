@@ -0,0 +1,98 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__POSITION_PATTERN_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__POSITION_PATTERN_H_INCLUDED
+
+#include "chessboard.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace hoover_chess_utils::utils
+{
+
+// Position pattern compiled into bitboard masks. The pattern is given as
+// whitespace-separated terms:
+// - KRPvKR     exact material. White pieces before 'v', black after. Kings
+//              are optional, but at most one per side.
+// - Nd5        white knight on d5. Upper case for white, lower case for
+//              black pieces.
+// - !pd6       no black pawn on d6
+// - w, b       side to move
+//
+// All terms must match.
+class PositionPattern
+{
+private:
+    // piece sets are indexed by color * 6 + (piece - 1)
+    static constexpr std::size_t ctNumPieceSets { 12U };
+
+    std::array<std::uint64_t, ctNumPieceSets> m_required { };
+    std::array<std::uint64_t, ctNumPieceSets> m_forbidden { };
+    std::array<std::uint64_t, ctNumPieceSets> m_counts { };
+
+    // all ones if the material is constrained, zero otherwise
+    std::uint64_t m_countMask { };
+
+    std::uint64_t m_turn { };
+
+    // all ones if the side to move is constrained, zero otherwise
+    std::uint64_t m_turnMask { };
+
+public:
+    // Compiles a pattern. Throws std::invalid_argument on syntax errors.
+    static PositionPattern compile(std::string_view pattern);
+
+    // Evaluates the pattern without branches: every term contributes
+    // mismatching bits, and the position matches when there are none.
+    inline bool matches(const pgn_reader::ChessBoard &board) const noexcept
+    {
+        const std::array<std::uint64_t, 2U> colors {
+            static_cast<std::uint64_t>(board.getWhitePieces()),
+            static_cast<std::uint64_t>(board.getBlackPieces()) };
+
+        const std::array<std::uint64_t, 6U> pieces {
+            static_cast<std::uint64_t>(board.getPawns()),
+            static_cast<std::uint64_t>(board.getKnights()),
+            static_cast<std::uint64_t>(board.getBishops()),
+            static_cast<std::uint64_t>(board.getRooks()),
+            static_cast<std::uint64_t>(board.getQueens()),
+            static_cast<std::uint64_t>(board.getKings()) };
+
+        std::uint64_t mismatch { };
+
+        for (std::size_t i { }; i < ctNumPieceSets; ++i)
+        {
+            const std::uint64_t bb { colors[i / 6U] & pieces[i % 6U] };
+
+            mismatch |= (bb & m_required[i]) ^ m_required[i];
+            mismatch |= bb & m_forbidden[i];
+            mismatch |= (static_cast<std::uint64_t>(std::popcount(bb)) ^ m_counts[i]) & m_countMask;
+        }
+
+        mismatch |= (static_cast<std::uint64_t>(board.getTurn()) ^ m_turn) & m_turnMask;
+
+        return mismatch == 0U;
+    }
+};
+
+}
+
+#endif
@@ -19,16 +19,25 @@
 #include "position-compress-fixed.h"
 #include "version.h"
 
+#include "bump-arena.h"
+#include "game-pipeline.h"
 #include "memory-mapped-file.h"
 #include "output-buffer.h"
+#include "process-in-order.h"
+#include "to-number.h"
 
-#include <charconv>
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <format>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <string_view>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -259,21 +268,6 @@ std::string classifyDfrc(std::string_view fen)
     return ret;
 }
 
-template <typename NumberType>
-NumberType toNumber(const char *str)
-{
-    NumberType ret { };
-    const std::string_view sv { str };
-    const std::from_chars_result result { std::from_chars(sv.data(), sv.data() + sv.size(), ret) };
-
-    if (result.ec == std::errc { })
-    {
-        return ret;
-    }
-
-    throw std::runtime_error { std::format("Error converting '{}' to number", sv) };
-}
-
 struct OpeningInfo
 {
     std::string eco;
@@ -346,11 +340,12 @@ public:
     }
 };
 
+// Collects the Event tag values of a PGN file. Consecutive duplicates are
+// dropped, so the sequence is short: one entry per sub-event, typically.
 class EventScannerActions : public pgn_reader::PgnReaderActions
 {
 private:
-    std::string m_previousEvent { };
-    std::uint32_t m_numSubEvents { };
+    std::vector<std::string> m_events { };
 
 public:
     void pgnTag(std::string_view key, std::string_view value) override
@@ -360,20 +355,128 @@ public:
             return;
 
         // do we already have this event?
-        if (m_previousEvent != value)
+        if (m_events.empty() || m_events.back() != value)
+            m_events.emplace_back(value);
+    }
+
+    const std::vector<std::string> &getEvents() const
+    {
+        return m_events;
+    }
+};
+
+// Event numbering state at the start of an input file. Sub-events continue
+// from the previous input files.
+struct SubEventState
+{
+    std::string previousEventValue { };
+    std::uint32_t subEventNumber { };
+};
+
+// Replays the event tag sequences of the input files in command-line
+// order. Returns the total number of sub-events and fills in the sub-event
+// numbering state at the start of every input file.
+std::uint32_t resolveSubEvents(
+    const std::vector<EventScannerActions> &scanners,
+    std::vector<SubEventState> &fileStates)
+{
+    std::string_view previousEvent { };
+    std::uint32_t numSubEvents { };
+    SubEventState state { };
+
+    fileStates.clear();
+    fileStates.reserve(scanners.size());
+
+    for (const EventScannerActions &scanner : scanners)
+    {
+        fileStates.push_back(state);
+
+        for (const std::string &event : scanner.getEvents())
         {
-            m_previousEvent = value;
-            ++m_numSubEvents;
+            // sub-event count: any change of the tag value
+            if (previousEvent != event)
+            {
+                previousEvent = event;
+                ++numSubEvents;
+            }
+
+            // sub-event numbering: games with an empty Event tag are
+            // skipped (see GameProcessor::normalizeEventTag())
+            if (!event.empty() && state.previousEventValue != event)
+            {
+                state.previousEventValue = event;
+                ++state.subEventNumber;
+            }
         }
     }
 
-    std::uint32_t getNumberOfSubEvents() const
+    return numSubEvents;
+}
+
+// Per-game record of the processing pipeline. Records are recycled, so the
+// buffers are reused between games.
+struct GameRecord
+{
+    // Storage for the tags and comments. Reset when the record is reused.
+    BumpArena arena { };
+
+    // PGN tags of the game
+    ArenaVector<ArenaString> knownTagValues { ctKnownTagsInOrder.size(), &arena };
+
+    // Values of "unknown" tags -- i.e., those that whose keys we don't know about.
+    // We'll assume there are only ever a handful of these, so we'll just keep them in a linear vector
+    ArenaVector<std::pair<ArenaString, ArenaString> > additionalPgnTags { &arena };
+
+    // moves of the game
+    pgn_reader::ChessBoard initialBoard { };
+    std::vector<pgn_reader::Move> moves { };
+
+    // comments associated with moves. Note: these come just before the move
+    ArenaVector<ArenaString> comments { &arena };
+
+    // result of the game
+    pgn_reader::PgnResult result { };
+
+    // the processed game in PGN
+    std::string output { };
+
+    void reset()
+    {
+        // Discard the arena-backed containers before resetting the
+        // arena. Deallocation is a no-op, so this just drops the storage.
+        comments = ArenaVector<ArenaString> { &arena };
+        knownTagValues = ArenaVector<ArenaString> { &arena };
+        additionalPgnTags = ArenaVector<std::pair<ArenaString, ArenaString> > { &arena };
+        arena.reset();
+
+        // all known tags are empty
+        knownTagValues.resize(ctKnownTagsInOrder.size());
+        comments.reserve(513U);
+
+        moves.clear();
+        moves.reserve(512U);
+        output.clear();
+    }
+
+    ArenaString &getValueRefForKnownPgnTag(KnownPgnTags tag)
     {
-        return m_numSubEvents;
+        const std::size_t i { static_cast<std::size_t>(tag) };
+        return knownTagValues[i];
+    }
+
+    const ArenaString &getValueRefForKnownPgnTag(KnownPgnTags tag) const
+    {
+        const std::size_t i { static_cast<std::size_t>(tag) };
+        return knownTagValues[i];
     }
 };
 
-class GameProcessorActions : public pgn_reader::PgnReaderActions
+// Game processing, split in pipeline stages:
+// - prepare() collects the game and normalizes the tags. This depends on the
+//   previous games, so it's invoked in input order.
+// - process() resolves the opening and renders the game. This is independent
+//   of the other games, so it's invoked in worker threads.
+class GameProcessor
 {
 private:
     std::string_view m_urlPrefix { };
@@ -382,17 +485,10 @@ private:
     const std::uint32_t m_numSubEvents;
     const EcoPgnReaderActions &m_eco;
 
-    const pgn_reader::ChessBoard *m_board { };
     std::uint32_t m_gameNo { };
 
-    // PGN tags of the game
-    std::array<std::string, std::tuple_size<decltype(ctKnownTagsInOrder)>::value> m_knownTagValues { };
     std::map<std::string_view, std::size_t> m_knownTagKeyToIndexMap { };
 
-    // Values of "unknown" tags -- i.e., those that whose keys we don't know about.
-    // We'll assume there are only ever a handful of these, so we'll just keep them in a linear vector
-    std::vector<std::pair<std::string, std::string> > m_additionalPgnTags { };
-
     // Previous event key--used to detect the next subevent
     const std::basic_regex<char> m_eventNamePruneMatcher {
         std::regex("^(TCEC )?(Season [[:digit:]]+)?([[:space:]]*[-][[:space:]]*)?", std::regex::extended) };
@@ -401,24 +497,6 @@ private:
     std::string m_previousProcessedEventName { };
     std::uint32_t m_subEventNumber { };
 
-    // previous game pending? This triggers printing out the moves and starting
-    // a new game on pgnTag(), moveTextSection(), or endOfPGN()
-    bool m_gamePending { };
-
-    // moves of the game
-    pgn_reader::ChessBoard m_initialBoard { };
-    std::vector<pgn_reader::Move> m_moves { };
-
-    // comments associated with moves. Note: these come just before the move
-    std::vector<std::string> m_comments { };
-
-    // result of the game
-    pgn_reader::PgnResult m_result { };
-
-    const OpeningInfo *m_openingInfo { };
-
-    OutputBuffer out { };
-
     static constexpr std::string_view ctLiteralResultWhiteWin { "1-0" };
     static constexpr std::string_view ctLiteralResultDraw { "1/2-1/2" };
     static constexpr std::string_view ctLiteralResultBlackWin { "0-1" };
@@ -430,101 +508,233 @@ private:
     static constexpr std::string_view ctLiteralPgnTagValueStart { " \"" };
     static constexpr std::string_view ctLiteralPgnTagValueEnd { "\"]\n" };
 
+    // space + move number + space + SAN
+    static constexpr std::size_t ctMaxMoveTextLength { 1U + 13U + 1U + 7U };
 
-    void writeEscapedPgnValue(const std::string_view value)
+    std::string getSubEventNameFromEventName(const std::string_view &eventName)
     {
-        for (char c : value)
-        {
-            if (c == '\\' || c == '"')
-                out.write('\\');
+        auto it = std::cregex_iterator(eventName.begin(), eventName.end(), m_eventNamePruneMatcher);
+        auto end = std::cregex_iterator();
 
-            out.write(c);
+        if (it != end)
+        {
+            std::cmatch match = *it;
+            return std::string { eventName.substr(match.length()) };
+        }
+        else
+        {
+            return std::string { eventName };
         }
     }
 
-    std::string &getValueRefForKnownPgnTag(KnownPgnTags tag)
+    void collectTag(GameRecord &record, std::string_view key, std::string_view value)
     {
-        const std::size_t i { static_cast<std::size_t>(tag) };
-        return m_knownTagValues[i];
+        // we don't store these, since we're classifying openings ourselves
+        if (key != "Opening" && key != "ECO" && key != "Variation" && key != "Site")
+        {
+            // do we know about this tag?
+            const auto i { std::as_const(m_knownTagKeyToIndexMap).find(key) };
+            if (i != m_knownTagKeyToIndexMap.end())
+            {
+                // ok, we do
+                record.knownTagValues.at(i->second) = value;
+            }
+            else
+            {
+                // ok, we don't. Do we have this tag already?
+                bool tagFound { };
+
+                for (auto &tag : record.additionalPgnTags)
+                {
+                    if (tag.first == key)
+                    {
+                        tag.second = value;
+                        tagFound = true;
+                        break;
+                    }
+                }
+
+                if (!tagFound)
+                {
+                    record.additionalPgnTags.emplace_back(key, value);
+                }
+            }
+        }
     }
 
-    std::string getSubEventNameFromEventName(const std::string_view &eventName)
+    static void collectComment(GameRecord &record, std::size_t moveIndex, std::string_view comment)
     {
-        auto it = std::cregex_iterator(eventName.begin(), eventName.end(), m_eventNamePruneMatcher);
-        auto end = std::cregex_iterator();
+        if (record.comments.size() < moveIndex + 1U)
+            record.comments.resize(moveIndex + 1U);
 
-        if (it != end)
+        ArenaString &moveComments { record.comments[moveIndex] };
+
+        if (moveComments.empty())
+            moveComments = comment;
+        else
         {
-            std::cmatch match = *it;
-            return std::string { eventName.substr(match.length()) };
+            moveComments += ' ';
+            moveComments += comment;
+        }
+    }
+
+    std::string formatEventName(std::string_view eventName, std::uint32_t subEventNumber)
+    {
+        if (m_numSubEvents >= 2U)
+        {
+            return std::format(
+                "TCEC Season {:02} ({:02}{}) {}",
+                m_seasonNumber,
+                m_eventNumber,
+                static_cast<char>('a' + subEventNumber),
+                getSubEventNameFromEventName(eventName));
         }
         else
         {
-            return std::string { eventName };
+            return std::format(
+                "TCEC Season {:02} ({:02}) {}",
+                m_seasonNumber,
+                m_eventNumber,
+                getSubEventNameFromEventName(eventName));
         }
     }
 
-    void flushPreviousGameAndStartNew()
+    void normalizeEventTag(GameRecord &record)
     {
-        if (m_gamePending)
+        auto &event { record.getValueRefForKnownPgnTag(KnownPgnTags::Event) };
+        if (!event.empty())
         {
-            printTags();
-            printMoves();
-            m_gamePending = false;
+            if (std::string_view { event } != m_previousEventValue)
+            {
+                m_previousProcessedEventName = formatEventName(event, m_subEventNumber);
+
+                ++m_subEventNumber;
+                m_previousEventValue = event;
+            }
+
+            event = m_previousProcessedEventName;
         }
+    }
 
-        m_moves.clear();
-        m_moves.reserve(512U);
-        m_comments.clear();
-        m_comments.reserve(513U);
-        m_openingInfo = nullptr;
+    static void checkResultTag(GameRecord &record)
+    {
+        const pgn_reader::PgnResult result { record.result };
 
-        // clear all known tags
-        for (auto &v : m_knownTagValues)
-            v.clear();
+        if (!record.getValueRefForKnownPgnTag(KnownPgnTags::Result).empty())
+        {
+            const ArenaString &pgnResultTag { record.getValueRefForKnownPgnTag(KnownPgnTags::Result) };
+            pgn_reader::PgnResult tagResult { };
 
-        // clear all additional tags
-        m_additionalPgnTags.clear();
+            if (pgnResultTag == ctLiteralResultWhiteWin)
+                tagResult = pgn_reader::PgnResult::WHITE_WIN;
+            else if (pgnResultTag == ctLiteralResultBlackWin)
+                tagResult = pgn_reader::PgnResult::BLACK_WIN;
+            else if (pgnResultTag == ctLiteralResultDraw)
+                tagResult = pgn_reader::PgnResult::DRAW;
+            else if (pgnResultTag == ctLiteralResultUnknown)
+                tagResult = pgn_reader::PgnResult::UNKNOWN;
+            else if (pgnResultTag == ctLiteralResultUnknown2)
+                tagResult = pgn_reader::PgnResult::UNKNOWN;
+            else
+            {
+                throw std::runtime_error(
+                    std::format("Bad result tag: '{}'", pgnResultTag));
+            }
 
-        if constexpr(debugMode)
+            if (tagResult != result)
+            {
+                throw std::runtime_error(
+                    std::format("PGN tag '{}' mismatches with the game result.", pgnResultTag));
+            }
+        }
+        else
         {
-            std::fputs(std::format("-- game {}\n", m_gameNo).c_str(), stderr);
+            ArenaString &pgnResultTag { record.getValueRefForKnownPgnTag(KnownPgnTags::Result) };
+            switch (result)
+            {
+                case pgn_reader::PgnResult::WHITE_WIN:
+                    pgnResultTag = ctLiteralResultWhiteWin;
+                    break;
+
+                case pgn_reader::PgnResult::BLACK_WIN:
+                    pgnResultTag = ctLiteralResultBlackWin;
+                    break;
+
+                case pgn_reader::PgnResult::DRAW:
+                    pgnResultTag = ctLiteralResultDraw;
+                    break;
+
+                case pgn_reader::PgnResult::UNKNOWN:
+                    pgnResultTag = ctLiteralResultUnknown;
+                    break;
+
+                default:
+                    throw std::runtime_error(
+                        std::format("Bad result code: '{}'", static_cast<std::uint8_t>(result)));
+            }
+        }
+    }
+
+    void resolveOpening(GameRecord &record) const
+    {
+        // the last position with a hit in the opening classification
+        // specifies the opening
+        const OpeningInfo *openingInfo { m_eco.getOpeningForPosition(record.initialBoard) };
+        pgn_reader::ChessBoard board { record.initialBoard };
+
+        for (pgn_reader::Move m : record.moves)
+        {
+            board.doMove(m);
+
+            const OpeningInfo *const positionOpeningInfo { m_eco.getOpeningForPosition(board) };
+            if (positionOpeningInfo != nullptr)
+                openingInfo = positionOpeningInfo;
+        }
+
+        if (openingInfo != nullptr)
+        {
+            if (!openingInfo->eco.empty())
+                record.getValueRefForKnownPgnTag(KnownPgnTags::ECO) = openingInfo->eco;
+            if (!openingInfo->opening.empty())
+                record.getValueRefForKnownPgnTag(KnownPgnTags::Opening) = openingInfo->opening;
+            if (!openingInfo->variation.empty())
+                record.getValueRefForKnownPgnTag(KnownPgnTags::Variation) = openingInfo->variation;
         }
     }
 
-    void printTags()
+    static void printTags(const GameRecord &record, OutputBuffer &out)
     {
         // tags with known keys and known order
-        for (std::size_t i { }; i < m_knownTagValues.size(); ++i)
+        for (std::size_t i { }; i < record.knownTagValues.size(); ++i)
         {
-            auto &value { m_knownTagValues[i] };
+            auto &value { record.knownTagValues[i] };
             if (value.empty())
                 continue;
 
             out.write('[');
             out.write(ctKnownTagsInOrder[i]);
             out.write(ctLiteralPgnTagValueStart);
-            writeEscapedPgnValue(value);
+            out.writeEscapedPgnValue(value);
             out.write(ctLiteralPgnTagValueEnd);
         }
 
         // any remaining tag is written in the order we encountered it
-        for (const auto &tag : m_additionalPgnTags)
+        for (const auto &tag : record.additionalPgnTags)
         {
             out.write('[');
             out.write(std::string_view(tag.first));
             out.write(std::string_view(" \""));
-            writeEscapedPgnValue(tag.second);
+            out.writeEscapedPgnValue(tag.second);
             out.write(std::string_view("\"]\n"));
         }
 
         // FRC/DFRC opening?
-        if ((!getValueRefForKnownPgnTag(KnownPgnTags::FEN).empty()) &&
-            getValueRefForKnownPgnTag(KnownPgnTags::ECO).empty() &&
-            getValueRefForKnownPgnTag(KnownPgnTags::Opening).empty() &&
-            getValueRefForKnownPgnTag(KnownPgnTags::Variation).empty())
+        if ((!record.getValueRefForKnownPgnTag(KnownPgnTags::FEN).empty()) &&
+            record.getValueRefForKnownPgnTag(KnownPgnTags::ECO).empty() &&
+            record.getValueRefForKnownPgnTag(KnownPgnTags::Opening).empty() &&
+            record.getValueRefForKnownPgnTag(KnownPgnTags::Variation).empty())
         {
-            std::string opening { classifyDfrc(getValueRefForKnownPgnTag(KnownPgnTags::FEN)) };
+            std::string opening { classifyDfrc(record.getValueRefForKnownPgnTag(KnownPgnTags::FEN)) };
             if (!opening.empty())
             {
                 out.write(std::string_view("[Opening \""));
@@ -536,46 +746,25 @@ private:
         out.write('\n');
     }
 
-    void printComment(std::string_view sv)
+    static void printComment(std::string_view sv, OutputBuffer &out)
     {
         out.write(ctLiteralBlockCommentStart);
-        bool eatWhiteSpace { true };
-        for (char c : sv)
-        {
-            if (c <= ' ')
-            {
-                if (eatWhiteSpace)
-                    continue;
-
-                out.write(' ');
-                eatWhiteSpace = true;
-            }
-            else
-            {
-                // map braces to parens, since braces can't appear in block comments
-                if (c == '{')
-                    c = '(';
-                if (c == '}')
-                    c = ')';
-
-                out.write(c);
-                eatWhiteSpace = false;
-            }
-        }
-
+        out.writeNormalizedComment(sv);
         out.write(ctLiteralBlockCommentEnd);
     }
 
-    void printMoves()
+    static void printMoves(const GameRecord &record, OutputBuffer &out)
     {
         bool spaceBeforeNextToken { };
         bool moveNumBeforeNextMove { true };
-        pgn_reader::ChessBoard board { m_initialBoard };
-        const std::size_t maxPrintPly { std::max(m_moves.size(), m_comments.size()) };
+        pgn_reader::ChessBoard board { record.initialBoard };
+        const std::vector<pgn_reader::Move> &moves { record.moves };
+        const ArenaVector<ArenaString> &comments { record.comments };
+        const std::size_t maxPrintPly { std::max(moves.size(), comments.size()) };
 
         for (size_t moveIndex { }; moveIndex < maxPrintPly; ++moveIndex)
         {
-            if (moveIndex < m_comments.size() && !m_comments[moveIndex].empty())
+            if (moveIndex < comments.size() && !comments[moveIndex].empty())
             {
                 if (spaceBeforeNextToken)
                 {
@@ -583,7 +772,7 @@ private:
                     spaceBeforeNextToken = false;
                 }
 
-                printComment(m_comments[moveIndex]);
+                printComment(comments[moveIndex], out);
                 if (moveIndex == 0U)
                     out.write('\n');
                 else
@@ -592,26 +781,31 @@ private:
                 moveNumBeforeNextMove = true;
             }
 
-            if (moveIndex < m_moves.size())
+            if (moveIndex < moves.size())
             {
                 const std::uint_fast32_t plyNum { board.getCurrentPlyNum() };
                 if (pgn_reader::colorOfPly(plyNum) == pgn_reader::Color::WHITE)
                     moveNumBeforeNextMove = true;
 
+                // separator, move number and SAN with a single reservation
+                char *const begin { out.reserve(ctMaxMoveTextLength) };
+                char *p { begin };
+
                 if (spaceBeforeNextToken)
                 {
-                    out.write(' ');
+                    *p++ = ' ';
                     spaceBeforeNextToken = false;
                 }
 
                 if (moveNumBeforeNextMove)
                 {
-                    out.write(pgn_reader::StringUtils::moveNumToString(pgn_reader::moveNumOfPly(plyNum), pgn_reader::colorOfPly(plyNum)));
-                    out.write(' ');
+                    p = OutputBuffer::put(p, pgn_reader::StringUtils::moveNumToString(pgn_reader::moveNumOfPly(plyNum), pgn_reader::colorOfPly(plyNum)).getStringView());
+                    *p++ = ' ';
                     moveNumBeforeNextMove = false;
                 }
 
-                out.write(pgn_reader::StringUtils::moveToSanAndPlay(board, m_moves[moveIndex]));
+                p = OutputBuffer::put(p, pgn_reader::StringUtils::moveToSanAndPlay(board, moves[moveIndex]).getStringView());
+                out.commit(static_cast<std::size_t>(p - begin));
                 spaceBeforeNextToken = true;
             }
         }
@@ -619,7 +813,7 @@ private:
         if (spaceBeforeNextToken)
             out.write(' ');
 
-        switch (m_result)
+        switch (record.result)
         {
             case pgn_reader::PgnResult::WHITE_WIN:
                 out.write(ctLiteralResultWhiteWin);
@@ -638,24 +832,16 @@ private:
                 break;
 
             default:
-                throw std::logic_error(std::format("Internal error: unknown result tag {}", static_cast<std::uint8_t>(m_result)));
+                throw std::logic_error(std::format("Internal error: unknown result tag {}", static_cast<std::uint8_t>(record.result)));
         }
 
         out.write(ctLiteralDoubleNewLine);
     }
 
-    void checkOpening()
-    {
-        const OpeningInfo *openingInfo { m_eco.getOpeningForPosition(*m_board) };
-
-        if (openingInfo != nullptr)
-            m_openingInfo = openingInfo;
-    }
-
 public:
-    GameProcessorActions(std::uint32_t seasonNumber, std::uint32_t eventNumber,
-                         std::uint32_t numSubEvents,
-                         const EcoPgnReaderActions &eco) :
+    GameProcessor(std::uint32_t seasonNumber, std::uint32_t eventNumber,
+                  std::uint32_t numSubEvents,
+                  const EcoPgnReaderActions &eco) :
         m_seasonNumber { seasonNumber },
         m_eventNumber { eventNumber },
         m_numSubEvents { numSubEvents },
@@ -675,192 +861,56 @@ public:
         m_gameNo = 0U;
     }
 
-    void setBoardReferences(
-        const pgn_reader::ChessBoard &curBoard,
-        const pgn_reader::ChessBoard &prevBoard) override
+    // Continues the sub-event numbering from the previous input files
+    void setSubEventState(const SubEventState &state)
     {
-        m_board = &curBoard;
-        static_cast<void>(prevBoard);
-    }
+        m_previousEventValue = state.previousEventValue;
+        m_subEventNumber = state.subEventNumber;
 
-    void gameStart() override
-    {
-        ++m_gameNo;
-    }
-
-    void pgnTag(std::string_view key, std::string_view value) override
-    {
-        if (m_gamePending)
-            flushPreviousGameAndStartNew();
-
-        // we don't store these, since we're classifying openings ourselves
-        if (key != "Opening" && key != "ECO" && key != "Variation" && key != "Site")
-        {
-            // do we know about this tag?
-            const auto i { std::as_const(m_knownTagKeyToIndexMap).find(key) };
-            if (i != m_knownTagKeyToIndexMap.end())
-            {
-                // ok, we do
-                m_knownTagValues.at(i->second) = value;
-            }
-            else
-            {
-                // ok, we don't. Do we have this tag already?
-                bool tagFound { };
-
-                for (auto &tag : m_additionalPgnTags)
-                {
-                    if (tag.first == key)
-                    {
-                        tag.second = value;
-                        tagFound = true;
-                        break;
-                    }
-                }
-
-                if (!tagFound)
-                {
-                    m_additionalPgnTags.emplace_back(std::string(key), std::string(value));
-                }
-            }
-        }
-    }
-
-    void comment(std::string_view comment) override
-    {
-        m_comments.resize(m_moves.size() + 1U);
-
-        if (m_comments.back().empty())
-            m_comments.back() = comment;
+        if (!m_previousEventValue.empty())
+            m_previousProcessedEventName = formatEventName(m_previousEventValue, m_subEventNumber - 1U);
         else
-        {
-            m_comments.back() += ' ';
-            m_comments.back() += comment;
-        }
-    }
-
-    void moveTextSection() override
-    {
-        if (m_gamePending)
-            flushPreviousGameAndStartNew();
-
-        m_initialBoard = *m_board;
-        checkOpening();
+            m_previousProcessedEventName.clear();
     }
 
-    void afterMove(pgn_reader::Move m) override
+    // Pipeline stage: invoked in input order
+    void prepare(GameRecord &record, const pgn_reader::PgnGameView &game)
     {
-        checkOpening();
-
-        m_moves.push_back(m);
-    }
+        ++m_gameNo;
 
-    void gameTerminated(pgn_reader::PgnResult result) override
-    {
-        auto &event { getValueRefForKnownPgnTag(KnownPgnTags::Event) };
-        if (!event.empty())
+        if constexpr(debugMode)
         {
-            if (event != m_previousEventValue)
-            {
-                if (m_numSubEvents >= 2U)
-                {
-                    m_previousProcessedEventName = std::format(
-                        "TCEC Season {:02} ({:02}{}) {}",
-                        m_seasonNumber,
-                        m_eventNumber,
-                        static_cast<char>('a' + m_subEventNumber),
-                        getSubEventNameFromEventName(event));
-                }
-                else
-                {
-                    m_previousProcessedEventName = std::format(
-                        "TCEC Season {:02} ({:02}) {}",
-                        m_seasonNumber,
-                        m_eventNumber,
-                        getSubEventNameFromEventName(event));
-                }
-
-                ++m_subEventNumber;
-                m_previousEventValue = event;
-            }
-
-            event = m_previousProcessedEventName;
+            std::fputs(std::format("-- game {}\n", m_gameNo).c_str(), stderr);
         }
 
-        getValueRefForKnownPgnTag(KnownPgnTags::Site) = std::format("{}&game={}", m_urlPrefix, m_gameNo);
+        record.reset();
 
-        if (!getValueRefForKnownPgnTag(KnownPgnTags::Result).empty())
-        {
-            const std::string &pgnResultTag { getValueRefForKnownPgnTag(KnownPgnTags::Result) };
-            pgn_reader::PgnResult tagResult { };
+        for (const pgn_reader::PgnGameTag &tag : game.tags)
+            collectTag(record, tag.key, tag.value);
 
-            if (pgnResultTag == ctLiteralResultWhiteWin)
-                tagResult = pgn_reader::PgnResult::WHITE_WIN;
-            else if (pgnResultTag == ctLiteralResultBlackWin)
-                tagResult = pgn_reader::PgnResult::BLACK_WIN;
-            else if (pgnResultTag == ctLiteralResultDraw)
-                tagResult = pgn_reader::PgnResult::DRAW;
-            else if (pgnResultTag == ctLiteralResultUnknown)
-                tagResult = pgn_reader::PgnResult::UNKNOWN;
-            else if (pgnResultTag == ctLiteralResultUnknown2)
-                tagResult = pgn_reader::PgnResult::UNKNOWN;
-            else
-            {
-                throw std::runtime_error(
-                    std::format("Bad result tag: '{}'", pgnResultTag));
-            }
+        for (const pgn_reader::PgnGameComment &comment : game.comments)
+            collectComment(record, comment.moveIndex, comment.text);
 
-            if (tagResult != result)
-            {
-                throw std::runtime_error(
-                    std::format("PGN tag '{}' mismatches with the game result.", pgnResultTag));
-            }
-        }
-        else
-        {
-            std::string &pgnResultTag { getValueRefForKnownPgnTag(KnownPgnTags::Result) };
-            switch (result)
-            {
-                case pgn_reader::PgnResult::WHITE_WIN:
-                    pgnResultTag = ctLiteralResultWhiteWin;
-                    break;
-
-                case pgn_reader::PgnResult::BLACK_WIN:
-                    pgnResultTag = ctLiteralResultBlackWin;
-                    break;
+        record.initialBoard = *game.initialBoard;
+        record.moves.assign(game.moves.begin(), game.moves.end());
+        record.result = game.result;
 
-                case pgn_reader::PgnResult::DRAW:
-                    pgnResultTag = ctLiteralResultDraw;
-                    break;
-
-                case pgn_reader::PgnResult::UNKNOWN:
-                    pgnResultTag = ctLiteralResultUnknown;
-                    break;
-
-                default:
-                    throw std::runtime_error(
-                        std::format("Bad result code: '{}'", static_cast<std::uint8_t>(result)));
-            }
-        }
+        normalizeEventTag(record);
 
-        if (m_openingInfo != nullptr)
-        {
-            if (!m_openingInfo->eco.empty())
-                getValueRefForKnownPgnTag(KnownPgnTags::ECO) = m_openingInfo->eco;
-            if (!m_openingInfo->opening.empty())
-                getValueRefForKnownPgnTag(KnownPgnTags::Opening) = m_openingInfo->opening;
-            if (!m_openingInfo->variation.empty())
-                getValueRefForKnownPgnTag(KnownPgnTags::Variation) = m_openingInfo->variation;
-        }
+        record.getValueRefForKnownPgnTag(KnownPgnTags::Site) = std::format("{}&game={}", m_urlPrefix, m_gameNo);
 
-        m_result = result;
-        m_gamePending = true;
+        checkResultTag(record);
     }
 
-    void endOfPGN() override
+    // Pipeline stage: invoked in worker threads
+    void process(GameRecord &record) const
     {
-        if (m_gamePending)
-            flushPreviousGameAndStartNew();
+        resolveOpening(record);
+
+        OutputBuffer out { record.output };
+        printTags(record, out);
+        printMoves(record, out);
+        out.flush();
     }
 };
 
@@ -885,7 +935,6 @@ int processFullTcecPgnMain(int argc, char **argv) noexcept
         const std::uint32_t eventNumber { toNumber<std::uint32_t>(argv[2]) };
 
         EcoPgnReaderActions ecoPgnActions { };
-        EventScannerActions eventScannerActions { };
 
         {
             MemoryMappedFile ecoPgn;
@@ -912,31 +961,96 @@ int processFullTcecPgnMain(int argc, char **argv) noexcept
             urlPrefixes.push_back(argv[(i * 2U) + 5U]);
         }
 
+        // The input files are processed concurrently. Every file thread runs
+        // a game pipeline, which has a parser thread and workers of its own.
+        const std::size_t hwThreads { std::max(std::thread::hardware_concurrency(), 1U) };
+        const std::size_t numFileThreads {
+            std::min(inputPgns.size(), std::max<std::size_t>(hwThreads / 2U, 1U)) };
+        const std::size_t numWorkersPerFile {
+            std::max<std::size_t>(hwThreads / numFileThreads, 2U) - 1U };
+
         // go through the PGNs, collect unique event tags and assign sub-event-numbers if multiple
+        std::vector<SubEventState> subEventStates { };
+        std::uint32_t numSubEvents { };
+
         {
-            for (auto &inputPgn : inputPgns)
-            {
-                pgn_reader::PgnReader::readFromMemory(
-                    inputPgn.getStringView(),
-                    eventScannerActions,
-                    PgnReaderActionFilter { PgnReaderActionClass::PgnTag });
-            }
+            std::vector<EventScannerActions> eventScanners(inputPgns.size());
+
+            processInOrder(
+                inputPgns.size(), hwThreads,
+                [&inputPgns, &eventScanners](std::size_t i)
+                {
+                    PgnReader::readFromMemory(
+                        inputPgns[i].getStringView(),
+                        eventScanners[i],
+                        PgnReaderActionFilter { PgnReaderActionClass::PgnTag });
+                },
+                [](std::size_t)
+                {
+                });
+
+            numSubEvents = resolveSubEvents(eventScanners, subEventStates);
         }
 
         // go through the PGNs, collect moves and comments, normalize tags, and resolve opening tags
         {
-            GameProcessorActions gameProcessorActions {
-                seasonNumber, eventNumber, eventScannerActions.getNumberOfSubEvents(), ecoPgnActions };
+            // Output is written in the command-line order. The head file,
+            // i.e., the first file not completed yet, is streamed straight to
+            // the output. The later files are buffered until they become the
+            // head.
+            std::vector<std::string> pendingOutputs(inputPgns.size());
+            std::size_t headFile { };
+            std::mutex outputMutex { };
+            OutputBuffer out { };
+
+            processInOrder(
+                inputPgns.size(), numFileThreads,
+                [&](std::size_t i)
+                {
+                    GameProcessor gameProcessor {
+                        seasonNumber, eventNumber, numSubEvents, ecoPgnActions };
+
+                    gameProcessor.setUrlPrefix(urlPrefixes.at(i));
+                    gameProcessor.setSubEventState(subEventStates.at(i));
+
+                    // one thread parses, the workers resolve openings and
+                    // render the games, and this thread collects them in order
+                    GamePipeline<GameRecord> pipeline { numWorkersPerFile, numWorkersPerFile * 4U };
+
+                    pipeline.run(
+                        inputPgns.at(i).getStringView(),
+                        [&gameProcessor](GameRecord &record, const pgn_reader::PgnGameView &game)
+                        {
+                            gameProcessor.prepare(record, game);
+                        },
+                        [&gameProcessor](GameRecord &record)
+                        {
+                            gameProcessor.process(record);
+                        },
+                        [&, i](GameRecord &record)
+                        {
+                            const std::lock_guard lock { outputMutex };
+
+                            if (i == headFile)
+                                out.write(std::string_view { record.output });
+                            else
+                                pendingOutputs[i] += record.output;
+                        });
+                },
+                [&](std::size_t i)
+                {
+                    const std::lock_guard lock { outputMutex };
 
-            for (std::size_t i { }; i < inputPgns.size(); ++i)
-            {
-                auto &inputPgn { inputPgns.at(i) };
-                gameProcessorActions.setUrlPrefix(urlPrefixes.at(i));
-                pgn_reader::PgnReader::readFromMemory(
-                    inputPgn.getStringView(),
-                    gameProcessorActions,
-                    PgnReaderActionFilter { PgnReaderActionClass::PgnTag, PgnReaderActionClass::Move, PgnReaderActionClass::Comment });
-            }
+                    // the next file becomes the head. Flush what it has
+                    // produced so far.
+                    headFile = i + 1U;
+
+                    if (headFile < pendingOutputs.size())
+                    {
+                        out.write(std::string_view { pendingOutputs[headFile] });
+                        std::string { }.swap(pendingOutputs[headFile]);
+                    }
+                });
         }
 
         for (auto &inputPgn : inputPgns)
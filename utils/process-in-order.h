@@ -0,0 +1,105 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__PROCESS_IN_ORDER_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__PROCESS_IN_ORDER_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace hoover_chess_utils::utils
+{
+
+// Invokes process(i) for i in [0, numItems) in worker threads, picking the
+// items in increasing order. complete(i) is invoked in the calling thread in
+// order, as soon as the item and all preceding items are processed.
+//
+// If process() or complete() throws, no further items are picked, and the
+// exception is rethrown after the workers have finished. Items preceding
+// the failed one are completed.
+template <typename T_Process, typename T_Complete>
+void processInOrder(std::size_t numItems, std::size_t numThreads, T_Process &&process, T_Complete &&complete)
+{
+    std::unique_ptr<std::atomic<bool>[]> done { std::make_unique<std::atomic<bool>[]>(numItems) };
+    std::vector<std::exception_ptr> errors(numItems);
+    std::atomic<std::size_t> nextItem { };
+    std::atomic<bool> stopRequested { };
+    std::exception_ptr error { };
+
+    {
+        std::vector<std::jthread> threads { };
+        numThreads = std::max<std::size_t>(std::min(numThreads, numItems), 1U);
+        threads.reserve(numThreads);
+
+        try
+        {
+            for (std::size_t t { }; t < numThreads; ++t)
+            {
+                threads.emplace_back(
+                    [&]() noexcept
+                    {
+                        while (!stopRequested.load(std::memory_order_relaxed))
+                        {
+                            const std::size_t i { nextItem.fetch_add(1U, std::memory_order_relaxed) };
+                            if (i >= numItems)
+                                break;
+
+                            try
+                            {
+                                process(i);
+                            }
+                            catch (...)
+                            {
+                                errors[i] = std::current_exception();
+                            }
+
+                            done[i].store(true, std::memory_order_release);
+                            done[i].notify_one();
+                        }
+                    });
+            }
+
+            for (std::size_t i { }; i < numItems; ++i)
+            {
+                done[i].wait(false, std::memory_order_acquire);
+
+                if (errors[i] != nullptr)
+                    std::rethrow_exception(errors[i]);
+
+                complete(i);
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+            stopRequested.store(true, std::memory_order_relaxed);
+        }
+
+        // joins the threads
+    }
+
+    if (error != nullptr)
+        std::rethrow_exception(error);
+}
+
+}
+
+#endif
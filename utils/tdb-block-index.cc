@@ -0,0 +1,336 @@
+// Hoover Chess Utilities / TDB query tool
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "tdb-block-index.h"
+#include "pgn-segments.h"
+#include "position-fingerprint.h"
+
+#include "chessboard.h"
+#include "pgnreader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace hoover_chess_utils::utils
+{
+
+namespace
+{
+
+class PositionHashCollectorActions : public pgn_reader::PgnReaderActions
+{
+private:
+    const pgn_reader::ChessBoard *m_board { };
+    std::vector<std::uint64_t> &m_hashes;
+
+    void addCurrentBoard()
+    {
+        pgn_reader::CompressedPosition_FixedLength cp;
+        pgn_reader::PositionCompressor_FixedLength::compress(*m_board, cp);
+
+        m_hashes.push_back(TdbBlockIndex::hashPosition(cp));
+    }
+
+public:
+    explicit PositionHashCollectorActions(std::vector<std::uint64_t> &hashes) noexcept :
+        m_hashes { hashes }
+    {
+    }
+
+    void setBoardReferences(
+        const pgn_reader::ChessBoard &curBoard,
+        const pgn_reader::ChessBoard &prevBoard) override
+    {
+        m_board = &curBoard;
+        static_cast<void>(prevBoard);
+    }
+
+    void moveTextSection() override
+    {
+        addCurrentBoard();
+    }
+
+    void afterMove(pgn_reader::Move) override
+    {
+        addCurrentBoard();
+    }
+};
+
+// Splits the database into blocks of gamesPerBlock games
+std::vector<TdbBlockIndexBlock> splitIntoBlocks(std::string_view databasePgn, std::size_t gamesPerBlock)
+{
+    std::vector<TdbBlockIndexBlock> blocks { };
+    std::size_t blockBegin { };
+    std::uint32_t numGames { databasePgn.empty() ? 0U : 1U };
+    std::size_t pos { };
+
+    while ((pos = findNextGameStart(databasePgn, pos + 1U)) < databasePgn.size())
+    {
+        if (numGames >= gamesPerBlock)
+        {
+            blocks.push_back(TdbBlockIndexBlock { blockBegin, pos, 0U, 0U, numGames });
+            blockBegin = pos;
+            numGames = 0U;
+        }
+
+        ++numGames;
+    }
+
+    if (blockBegin < databasePgn.size())
+        blocks.push_back(TdbBlockIndexBlock { blockBegin, databasePgn.size(), 0U, 0U, numGames });
+
+    return blocks;
+}
+
+inline std::size_t probeBit(std::uint64_t positionHash, std::uint32_t probe, std::uint64_t bitMask) noexcept
+{
+    // double hashing
+    const std::uint64_t step { std::rotl(positionHash, 32) | 1U };
+    return (positionHash + probe * step) & bitMask;
+}
+
+void buildFilter(
+    std::string_view blockPgn, TdbBlockIndexBlock &block, std::vector<std::uint64_t> &filterWords)
+{
+    std::vector<std::uint64_t> hashes { };
+    PositionHashCollectorActions actions { hashes };
+
+    pgn_reader::PgnReader::readFromMemory(
+        blockPgn,
+        actions,
+        pgn_reader::PgnReaderActionFilter { pgn_reader::PgnReaderActionClass::Move });
+
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    // at least one cache line per filter
+    const std::uint64_t minNumBits {
+        std::max<std::uint64_t>(hashes.size() * TdbBlockIndex::ctBitsPerPosition, 512U) };
+
+    block.filterLog2NumBits = std::bit_width(minNumBits - 1U);
+
+    const std::uint64_t bitMask { (std::uint64_t { 1U } << block.filterLog2NumBits) - 1U };
+
+    filterWords.assign((bitMask + 1U) / 64U, 0U);
+
+    for (std::uint64_t hash : hashes)
+    {
+        for (std::uint32_t probe { }; probe < TdbBlockIndex::ctNumProbes; ++probe)
+        {
+            const std::size_t bit { probeBit(hash, probe, bitMask) };
+            filterWords[bit / 64U] |= std::uint64_t { 1U } << (bit % 64U);
+        }
+    }
+}
+
+void writeOrThrow(std::FILE *f, const void *data, std::size_t size, const char *fileName)
+{
+    if (size != 0U && std::fwrite(data, size, 1U, f) != 1U)
+    {
+        const int err { errno };
+        std::fclose(f);
+
+        throw std::system_error(err, std::generic_category(), std::format("Failed to write {}", fileName));
+    }
+}
+
+}
+
+std::uint64_t TdbBlockIndex::hashPosition(const pgn_reader::CompressedPosition_FixedLength &cp) noexcept
+{
+    return positionFingerprint(cp);
+}
+
+std::uint64_t TdbBlockIndex::hashDatabaseContent(std::string_view databasePgn) noexcept
+{
+    // FNV-1a, so that the hash stays the same across builds
+    const auto hashBytes {
+        [](std::uint64_t h, std::string_view bytes) noexcept
+        {
+            for (const char c : bytes)
+            {
+                h ^= static_cast<unsigned char>(c);
+                h *= UINT64_C(0x100000001B3);
+            }
+
+            return h;
+        } };
+
+    // the head and the tail do not overlap
+    const std::size_t headSize { std::min(databasePgn.size(), ctContentHashBytes) };
+    const std::size_t tailSize { std::min(databasePgn.size() - headSize, ctContentHashBytes) };
+
+    std::uint64_t h { UINT64_C(0xCBF29CE484222325) };
+    h = hashBytes(h, databasePgn.substr(0U, headSize));
+    h = hashBytes(h, databasePgn.substr(databasePgn.size() - tailSize));
+
+    return h;
+}
+
+void TdbBlockIndex::build(
+    std::string_view databasePgn, const char *indexFileName,
+    std::size_t gamesPerBlock, std::size_t numThreads)
+{
+    std::vector<TdbBlockIndexBlock> blocks { splitIntoBlocks(databasePgn, std::max<std::size_t>(gamesPerBlock, 1U)) };
+    std::vector<std::vector<std::uint64_t> > filters(blocks.size());
+    std::vector<std::exception_ptr> errors(blocks.size());
+
+    // build the filters
+    {
+        std::atomic<std::size_t> nextBlock { };
+        std::vector<std::jthread> threads { };
+
+        numThreads = std::max<std::size_t>(std::min(numThreads, blocks.size()), 1U);
+
+        for (std::size_t t { }; t < numThreads; ++t)
+        {
+            threads.emplace_back(
+                [&]() noexcept
+                {
+                    while (true)
+                    {
+                        const std::size_t i { nextBlock.fetch_add(1U, std::memory_order_relaxed) };
+                        if (i >= blocks.size())
+                            break;
+
+                        TdbBlockIndexBlock &block { blocks[i] };
+
+                        try
+                        {
+                            buildFilter(
+                                databasePgn.substr(block.pgnBegin, block.pgnEnd - block.pgnBegin),
+                                block, filters[i]);
+                        }
+                        catch (...)
+                        {
+                            errors[i] = std::current_exception();
+                        }
+                    }
+                });
+        }
+
+        // joins the threads
+    }
+
+    std::uint64_t filterOffset { };
+    for (std::size_t i { }; i < blocks.size(); ++i)
+    {
+        if (errors[i] != nullptr)
+            std::rethrow_exception(errors[i]);
+
+        blocks[i].filterOffset = filterOffset;
+        filterOffset += filters[i].size();
+    }
+
+    // write out
+    const TdbBlockIndexHeader header {
+        ctMagic, ctVersion, ctNumProbes, databasePgn.size(), hashDatabaseContent(databasePgn), blocks.size() };
+
+    std::FILE *const f { std::fopen(indexFileName, "wb") };
+    if (f == nullptr)
+        throw std::system_error(errno, std::generic_category(), std::format("Failed to open {}", indexFileName));
+
+    writeOrThrow(f, &header, sizeof header, indexFileName);
+    writeOrThrow(f, blocks.data(), blocks.size() * sizeof(TdbBlockIndexBlock), indexFileName);
+
+    for (const std::vector<std::uint64_t> &filter : filters)
+        writeOrThrow(f, filter.data(), filter.size() * sizeof(std::uint64_t), indexFileName);
+
+    if (std::fclose(f) != 0)
+        throw std::system_error(errno, std::generic_category(), std::format("Failed to write {}", indexFileName));
+}
+
+bool TdbBlockIndex::load(const char *indexFileName, std::string_view databasePgn)
+{
+    m_file.unmap();
+    m_header = nullptr;
+
+    std::error_code ec { };
+    if (!std::filesystem::is_regular_file(indexFileName, ec) || std::filesystem::file_size(indexFileName, ec) == 0U)
+        return false;
+
+    m_file.map(indexFileName, true, false);
+
+    const std::byte *const data { static_cast<const std::byte *>(m_file.data()) };
+    const std::size_t size { m_file.size() };
+
+    if (size < sizeof(TdbBlockIndexHeader))
+        return false;
+
+    const TdbBlockIndexHeader *const header { reinterpret_cast<const TdbBlockIndexHeader *>(data) };
+
+    if (header->magic != ctMagic || header->version != ctVersion || header->databaseSize != databasePgn.size())
+        return false;
+
+    if (header->databaseContentHash != hashDatabaseContent(databasePgn))
+        return false;
+
+    const std::uint64_t maxNumBlocks { (size - sizeof(TdbBlockIndexHeader)) / sizeof(TdbBlockIndexBlock) };
+    if (header->numBlocks > maxNumBlocks)
+        return false;
+
+    const std::size_t filtersBegin {
+        sizeof(TdbBlockIndexHeader) + header->numBlocks * sizeof(TdbBlockIndexBlock) };
+
+    m_blocks = reinterpret_cast<const TdbBlockIndexBlock *>(data + sizeof(TdbBlockIndexHeader));
+    m_filterWords = reinterpret_cast<const std::uint64_t *>(data + filtersBegin);
+    m_numFilterWords = (size - filtersBegin) / sizeof(std::uint64_t);
+
+    // validate the block table, so that queries need no range checks
+    for (std::size_t i { }; i < header->numBlocks; ++i)
+    {
+        const TdbBlockIndexBlock &block { m_blocks[i] };
+
+        if (block.pgnBegin > block.pgnEnd || block.pgnEnd > databasePgn.size() ||
+            block.filterLog2NumBits < 6U || block.filterLog2NumBits > 40U ||
+            block.filterOffset > m_numFilterWords ||
+            (std::uint64_t { 1U } << (block.filterLog2NumBits - 6U)) > m_numFilterWords - block.filterOffset)
+        {
+            return false;
+        }
+    }
+
+    m_header = header;
+    return true;
+}
+
+bool TdbBlockIndex::mayContain(std::size_t blockIndex, std::uint64_t positionHash) const noexcept
+{
+    const TdbBlockIndexBlock &block { m_blocks[blockIndex] };
+    const std::uint64_t *const filter { m_filterWords + block.filterOffset };
+    const std::uint64_t bitMask { (std::uint64_t { 1U } << block.filterLog2NumBits) - 1U };
+
+    for (std::uint32_t probe { }; probe < m_header->numProbes; ++probe)
+    {
+        const std::size_t bit { probeBit(positionHash, probe, bitMask) };
+
+        if ((filter[bit / 64U] & (std::uint64_t { 1U } << (bit % 64U))) == 0U)
+            return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,125 @@
+// Hoover Chess Utilities / TDB query tool
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__TDB_BLOCK_INDEX_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__TDB_BLOCK_INDEX_H_INCLUDED
+
+#include "memory-mapped-file.h"
+
+#include "position-compress-fixed.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace hoover_chess_utils::utils
+{
+
+// Block-level position skip index for a PGN database. The database is split
+// into game-aligned blocks, and for every block, there is a bloom filter
+// over the hashes of the positions occurring in the block's games. A query
+// needs to parse only the blocks whose filters match with the query
+// positions. Bloom filters have no false negatives, so the query results
+// are exact.
+//
+// The index is stored in a sidecar file in native byte order:
+// - header (TdbBlockIndexHeader)
+// - block table (TdbBlockIndexBlock[numBlocks])
+// - filter words (std::uint64_t[])
+struct TdbBlockIndexHeader
+{
+    std::array<char, 8U> magic;
+    std::uint32_t version;
+    std::uint32_t numProbes;
+    std::uint64_t databaseSize;
+
+    // hash of the first and the last ctContentHashBytes of the database
+    std::uint64_t databaseContentHash;
+
+    std::uint64_t numBlocks;
+};
+
+struct TdbBlockIndexBlock
+{
+    // PGN range of the block, [pgnBegin, pgnEnd)
+    std::uint64_t pgnBegin;
+    std::uint64_t pgnEnd;
+
+    // first filter word, relative to the start of the filter words
+    std::uint64_t filterOffset;
+    std::uint32_t filterLog2NumBits;
+    std::uint32_t numGames;
+};
+
+class TdbBlockIndex
+{
+public:
+    static constexpr std::array<char, 8U> ctMagic { 'H', 'T', 'D', 'B', 'I', 'D', 'X', '\0' };
+    static constexpr std::uint32_t ctVersion { 2U };
+
+    static constexpr std::size_t ctDefaultGamesPerBlock { 256U };
+
+    // database content check on load
+    static constexpr std::size_t ctContentHashBytes { 64U * 1024U };
+
+    // ~0.05% false positive rate per position and block
+    static constexpr std::uint32_t ctBitsPerPosition { 16U };
+    static constexpr std::uint32_t ctNumProbes { 11U };
+
+private:
+    MemoryMappedFile m_file { };
+    const TdbBlockIndexHeader *m_header { };
+    const TdbBlockIndexBlock *m_blocks { };
+    const std::uint64_t *m_filterWords { };
+    std::size_t m_numFilterWords { };
+
+public:
+    static std::uint64_t hashPosition(const pgn_reader::CompressedPosition_FixedLength &cp) noexcept;
+
+    // Hashes the first and the last ctContentHashBytes of the database. This
+    // catches the typical database edits without reading the whole file.
+    static std::uint64_t hashDatabaseContent(std::string_view databasePgn) noexcept;
+
+    // Builds the index for a database and writes it to a file. The blocks
+    // are processed in numThreads threads.
+    static void build(
+        std::string_view databasePgn, const char *indexFileName,
+        std::size_t gamesPerBlock, std::size_t numThreads);
+
+    // Maps an index file. Returns false if the file is not a valid index
+    // for the database, that is, if the database size or content hash does
+    // not match.
+    bool load(const char *indexFileName, std::string_view databasePgn);
+
+    std::size_t getNumBlocks() const noexcept
+    {
+        return m_header != nullptr ? m_header->numBlocks : 0U;
+    }
+
+    const TdbBlockIndexBlock &getBlock(std::size_t blockIndex) const noexcept
+    {
+        return m_blocks[blockIndex];
+    }
+
+    // Returns false if the block does not contain the position with the
+    // hash. Returns true if the block may contain the position.
+    bool mayContain(std::size_t blockIndex, std::uint64_t positionHash) const noexcept;
+};
+
+}
+
+#endif
@@ -15,6 +15,8 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "memory-mapped-file.h"
+#include "pgn-segments.h"
+#include "tdb-block-index.h"
 
 #include "pgnreader.h"
 #include "pgnreader-string-utils.h"
@@ -27,11 +29,13 @@
 #include <charconv>
 #include <chrono>
 #include <cstdint>
+#include <filesystem>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <stdexcept>
 #include <string>
+#include <span>
 #include <string_view>
 #include <thread>
 #include <vector>
@@ -72,6 +76,10 @@ struct PositionResultStats
     std::string whitePlayer;
     std::string blackPlayer;
     std::string site;
+
+    // database offset of the PGN segment of the most recent game. Used to
+    // order the games when the results of the segments are merged.
+    std::size_t segmentOffset;
 };
 
 // we gather the stats for each unique position given in the input FEN + moves
@@ -85,10 +93,15 @@ void printHelp()
     std::cout << "TCEC games database query tool for TCEC_hoover_bot (" << hoover_chess_utils::pgn_reader::getVersionString() << ')' << std::endl;
     std::cout << std::endl;
     std::cout << "Usage: hoover-tdb-query <PGN-database> <PGN-query> [threads]" << std::endl;
+    std::cout << "       hoover-tdb-query --build-index <PGN-database> [threads]" << std::endl;
     std::cout << std::endl;
     std::cout << "PGN-database  Compacted TCEC games PGN database file" << std::endl;
     std::cout << "PGN-query     PGN containing a single game. The positions in the PGN are queried" << std::endl;
     std::cout << "              in reverse order." << std::endl;
+    std::cout << std::endl;
+    std::cout << "--build-index builds the position skip index <PGN-database>.idx. When the index" << std::endl;
+    std::cout << "              exists and matches with the database, queries parse only the" << std::endl;
+    std::cout << "              database blocks that may contain the query positions." << std::endl;
 }
 
 class CollectQueryFilePositionsActions : public pgn_reader::PgnReaderActions
@@ -151,6 +164,7 @@ private:
 
     // current database game
     const hoover_chess_utils::pgn_reader::ChessBoard *m_board { };
+    std::size_t m_segmentOffset { };
     std::string m_whitePlayer;
     std::string m_blackPlayer;
     std::string m_site;
@@ -182,6 +196,11 @@ public:
         m_inputPositionsSeen.resize(inputPositions.size());
     }
 
+    void setSegmentOffset(std::size_t segmentOffset) noexcept
+    {
+        m_segmentOffset = segmentOffset;
+    }
+
     void setBoardReferences(
         const hoover_chess_utils::pgn_reader::ChessBoard &curBoard,
         const hoover_chess_utils::pgn_reader::ChessBoard &prevBoard) override
@@ -310,117 +329,137 @@ public:
                 resultStats.whitePlayer = m_whitePlayer;
                 resultStats.blackPlayer = m_blackPlayer;
                 resultStats.site = m_site;
+                resultStats.segmentOffset = m_segmentOffset;
             }
         }
     }
 };
 
-std::string_view::iterator findNextGameStart(std::string_view fullPgn, std::size_t b)
+std::string_view::iterator findSegmentBoundary(std::string_view fullPgn, std::size_t b)
 {
-    if (b == 0U || b == fullPgn.size())
-        return fullPgn.begin() + b;
-
-    // find next game
-    const char *gameStartTag = "\n\n["; // empty line + PGN header tag
-    const std::size_t pos { fullPgn.find(gameStartTag, b) };
+    if (b == 0U)
+        return fullPgn.begin();
 
-    if (pos == std::string_view::npos)
-        return fullPgn.end();
-    else
-        return fullPgn.begin() + pos;
+    return fullPgn.begin() + findNextGameStart(fullPgn, b);
 }
 
 void collectStatisticsThreadMain(
     const std::vector<pgn_reader::CompressedPosition_FixedLength> &positions,
     std::string_view databasePgn,
-    std::size_t segmentNo,
-    std::size_t numSegments,
+    std::span<const std::string_view> pgnSegments,
     std::vector<PositionStats> &result)
 {
-    // get the segment of the full pgn for this thread
-    std::string_view pgnSegment {
-        findNextGameStart(databasePgn, databasePgn.size() * segmentNo / numSegments),
-        findNextGameStart(databasePgn, databasePgn.size() * (segmentNo + 1U) / numSegments) };
-
-    if constexpr (debugMode)
-    {
-        std::cout << std::format("Thread {}: target={} slice=[{}, {})",
-                                 segmentNo,
-                                 databasePgn.size() * segmentNo / numSegments,
-                                 pgnSegment.begin() - databasePgn.begin(),
-                                 pgnSegment.end() - databasePgn.begin())
-                  << std::endl;
-    }
-
     CollectStatisticsActions actions { positions, result };
 
     using pgn_reader::PgnReader;
     using pgn_reader::PgnReaderActionClass;
     using pgn_reader::PgnReaderActionFilter;
 
-    PgnReader::readFromMemory(
-        pgnSegment,
-        actions,
-        PgnReaderActionFilter { PgnReaderActionClass::PgnTag, PgnReaderActionClass::Move, PgnReaderActionClass::Comment });
+    for (std::string_view pgnSegment : pgnSegments)
+    {
+        if constexpr (debugMode)
+        {
+            std::cout << std::format("Segment [{}, {})",
+                                     pgnSegment.begin() - databasePgn.begin(),
+                                     pgnSegment.end() - databasePgn.begin())
+                      << std::endl;
+        }
+
+        actions.setSegmentOffset(pgnSegment.begin() - databasePgn.begin());
+
+        PgnReader::readFromMemory(
+            pgnSegment,
+            actions,
+            PgnReaderActionFilter { PgnReaderActionClass::PgnTag, PgnReaderActionClass::Move, PgnReaderActionClass::Comment });
+    }
 }
 
-std::vector<PositionStats> collectStatistics(
+// Collects the statistics from non-overlapping game-aligned PGN segments and
+// merges them into stats. The segments are split in contiguous runs of
+// roughly equal size between the threads.
+void collectStatisticsFromSegments(
     const std::vector<pgn_reader::CompressedPosition_FixedLength> &positions,
-    const std::string &dbFileName,
-    std::size_t numThreads)
+    std::string_view databasePgn,
+    const std::vector<std::string_view> &pgnSegments,
+    std::size_t numThreads,
+    std::vector<PositionStats> &stats)
 {
+    std::size_t totalSize { };
+    for (std::string_view pgnSegment : pgnSegments)
+        totalSize += pgnSegment.size();
+
+    numThreads = std::clamp(numThreads, std::size_t { 1U }, std::max<std::size_t>(pgnSegments.size(), 1U));
+
+    // segment runs: [runBegin[i], runBegin[i + 1])
+    std::vector<std::size_t> runBegin(numThreads + 1U, pgnSegments.size());
+    {
+        std::size_t segmentSizeSum { };
+        std::size_t thread { };
+
+        runBegin[0U] = 0U;
+
+        for (std::size_t i { }; i < pgnSegments.size(); ++i)
+        {
+            while (thread + 1U < numThreads && segmentSizeSum * numThreads >= totalSize * (thread + 1U))
+                runBegin[++thread] = i;
+
+            segmentSizeSum += pgnSegments[i].size();
+        }
+    }
+
     std::vector<std::thread> threads;
     std::vector<std::vector<PositionStats> > threadResults;
 
     threads.resize(numThreads);
     threadResults.resize(numThreads);
 
-    MemoryMappedFile mmfile { };
-    mmfile.map(dbFileName.c_str(), true, false);
-
     if constexpr (debugMode)
     {
         std::cout << "Launching " << numThreads << " to collect results..." << std::endl;
     }
 
+    const std::span<const std::string_view> allSegments { pgnSegments };
+
     for (std::size_t i { }; i < threads.size(); ++i)
     {
         threads.at(i) =
             std::thread(
                 collectStatisticsThreadMain,
                 std::cref(positions),
-                std::string_view(static_cast<const char *>(mmfile.data()), mmfile.size()),
-                i,
-                numThreads,
+                databasePgn,
+                allSegments.subspan(runBegin[i], runBegin[i + 1U] - runBegin[i]),
                 std::ref(threadResults.at(i)));
     }
 
+    stats.resize(positions.size());
+
     for (std::size_t i { }; i < threads.size(); ++i)
     {
         threads.at(i).join();
 
-        if (i > 0U)
-        {
-            std::vector<PositionStats> &firstThreadResults { threadResults.at(0U) };
-            const std::vector<PositionStats> &curThreadResults { threadResults.at(i) };
+        const std::vector<PositionStats> &curThreadResults { threadResults.at(i) };
 
-            for (std::size_t inputPosNum { }; inputPosNum < positions.size(); ++inputPosNum)
+        for (std::size_t inputPosNum { }; inputPosNum < positions.size(); ++inputPosNum)
+        {
+            for (std::size_t resultIndex { };
+                 resultIndex < static_cast<std::size_t>(PositionClassification::NUM_VALUES);
+                 ++resultIndex)
             {
-                for (std::size_t resultIndex { };
-                     resultIndex < static_cast<std::size_t>(PositionClassification::NUM_VALUES);
-                     ++resultIndex)
+                const PositionResultStats &curThreadStats { curThreadResults.at(inputPosNum).resultStats.at(resultIndex) };
+
+                if (curThreadStats.numGames > 0U)
                 {
-                    const PositionResultStats &curThreadStats { curThreadResults.at(inputPosNum).resultStats.at(resultIndex) };
+                    PositionResultStats &sumStats { stats.at(inputPosNum).resultStats.at(resultIndex) };
 
-                    if (curThreadStats.numGames > 0U)
+                    if (sumStats.numGames == 0U || curThreadStats.segmentOffset >= sumStats.segmentOffset)
                     {
-                        PositionResultStats &sumStats { firstThreadResults.at(inputPosNum).resultStats.at(resultIndex) };
-
-                        sumStats.numGames    += curThreadStats.numGames;
-                        sumStats.whitePlayer =  curThreadStats.whitePlayer;
-                        sumStats.blackPlayer =  curThreadStats.blackPlayer;
-                        sumStats.site        =  curThreadStats.site;
+                        sumStats.whitePlayer   = curThreadStats.whitePlayer;
+                        sumStats.blackPlayer   = curThreadStats.blackPlayer;
+                        sumStats.site          = curThreadStats.site;
+                        sumStats.segmentOffset = curThreadStats.segmentOffset;
                     }
+
+                    sumStats.numGames += curThreadStats.numGames;
                 }
             }
         }
@@ -430,10 +469,135 @@ std::vector<PositionStats> collectStatistics(
     {
         std::cout << "Threads done" << std::endl;
     }
+}
+
+bool hasGames(const PositionStats &stats) noexcept
+{
+    for (const PositionResultStats &resultStats : stats.resultStats)
+    {
+        if (resultStats.numGames > 0U)
+            return true;
+    }
+
+    return false;
+}
+
+// Collects the statistics using the position skip index. Only the result of
+// the highest-ply query position found in the database is printed, so the
+// query positions are resolved in descending ply order. For every position,
+// the blocks that may contain it and that are not yet parsed are
+// parsed. Once the position is found, its statistics are complete, since
+// the bloom filters have no false negatives. The statistics of the
+// lower-ply positions may be incomplete.
+std::vector<PositionStats> collectStatisticsWithIndex(
+    const std::vector<pgn_reader::CompressedPosition_FixedLength> &positions,
+    const std::vector<std::uint32_t> &positionPlyNums,
+    std::string_view databasePgn,
+    const TdbBlockIndex &index,
+    std::size_t numThreads)
+{
+    std::vector<PositionStats> stats(positions.size());
+    std::vector<bool> blockParsed(index.getNumBlocks());
+    std::size_t numBlocksParsed { };
+
+    std::vector<std::size_t> positionOrder(positions.size());
+    for (std::size_t i { }; i < positionOrder.size(); ++i)
+        positionOrder[i] = i;
+
+    std::sort(
+        positionOrder.begin(), positionOrder.end(),
+        [&positionPlyNums](std::size_t lhs, std::size_t rhs)
+        {
+            return positionPlyNums[lhs] > positionPlyNums[rhs];
+        });
+
+    for (std::size_t positionIndex : positionOrder)
+    {
+        const std::uint64_t hash { TdbBlockIndex::hashPosition(positions[positionIndex]) };
+        std::vector<std::string_view> pgnSegments { };
+
+        for (std::size_t blockIndex { }; blockIndex < index.getNumBlocks(); ++blockIndex)
+        {
+            if (blockParsed[blockIndex] || !index.mayContain(blockIndex, hash))
+                continue;
+
+            const TdbBlockIndexBlock &block { index.getBlock(blockIndex) };
+            const std::string_view blockPgn {
+                databasePgn.substr(block.pgnBegin, block.pgnEnd - block.pgnBegin) };
+
+            // merge with the previous segment if adjacent
+            if (!pgnSegments.empty() && pgnSegments.back().end() == blockPgn.begin())
+                pgnSegments.back() = std::string_view { pgnSegments.back().begin(), blockPgn.end() };
+            else
+                pgnSegments.push_back(blockPgn);
+
+            blockParsed[blockIndex] = true;
+            ++numBlocksParsed;
+        }
+
+        if (!pgnSegments.empty())
+            collectStatisticsFromSegments(positions, databasePgn, pgnSegments, numThreads, stats);
+
+        if (hasGames(stats[positionIndex]))
+            break;
+    }
+
+    if constexpr (debugMode)
+    {
+        std::cout << std::format("Parsed {}/{} blocks", numBlocksParsed, index.getNumBlocks()) << std::endl;
+    }
+
+    return stats;
+}
+
+std::vector<PositionStats> collectStatistics(
+    const std::vector<pgn_reader::CompressedPosition_FixedLength> &positions,
+    const std::vector<std::uint32_t> &positionPlyNums,
+    const std::string &dbFileName,
+    std::size_t numThreads)
+{
+    std::vector<PositionStats> stats { };
+
+    MemoryMappedFile mmfile { };
+    mmfile.map(dbFileName.c_str(), true, false);
+
+    const std::string_view databasePgn { mmfile.getStringView() };
+
+    TdbBlockIndex index { };
+    if (index.load((dbFileName + ".idx").c_str(), databasePgn))
+    {
+        stats = collectStatisticsWithIndex(positions, positionPlyNums, databasePgn, index, numThreads);
+    }
+    else
+    {
+        // full scan: one segment per thread
+        std::vector<std::string_view> pgnSegments { };
+
+        for (std::size_t i { }; i < numThreads; ++i)
+        {
+            pgnSegments.emplace_back(
+                findSegmentBoundary(databasePgn, databasePgn.size() * i / numThreads),
+                findSegmentBoundary(databasePgn, databasePgn.size() * (i + 1U) / numThreads));
+        }
+
+        collectStatisticsFromSegments(positions, databasePgn, pgnSegments, numThreads, stats);
+    }
 
     mmfile.unmap();
 
-    return threadResults.at(0);
+    return stats;
+}
+
+void buildIndex(const std::string &dbFileName, std::size_t numThreads)
+{
+    MemoryMappedFile mmfile { };
+    mmfile.map(dbFileName.c_str(), true, false);
+
+    TdbBlockIndex::build(
+        mmfile.getStringView(), (dbFileName + ".idx").c_str(),
+        TdbBlockIndex::ctDefaultGamesPerBlock, numThreads);
+
+    mmfile.unmap();
 }
 
 std::pair<std::vector<pgn_reader::CompressedPosition_FixedLength>, std::vector<std::uint32_t> > collectQueryFilePositions(const std::string &fileName)
@@ -665,8 +829,7 @@ int tdbQueryMain(int argc, char **argv) noexcept
 
     try
     {
-        const std::string pgnDatabaseFile { argv[1] };
-        const std::string pgnQueryFile { argv[2] };
+        const bool buildIndexMode { std::string_view { argv[1] } == "--build-index" };
         std::size_t threads { 1U };
 
         if (argc == 4)
@@ -677,12 +840,21 @@ int tdbQueryMain(int argc, char **argv) noexcept
             threads = std::clamp(threads, std::size_t { 1U }, std::size_t { 256U });
         }
 
+        if (buildIndexMode)
+        {
+            buildIndex(argv[2], threads);
+            return 0;
+        }
+
+        const std::string pgnDatabaseFile { argv[1] };
+        const std::string pgnQueryFile { argv[2] };
+
         std::vector<pgn_reader::CompressedPosition_FixedLength> positions;
         std::vector<std::uint32_t> positionPlyNums;
 
         std::tie(positions, positionPlyNums) = collectQueryFilePositions(pgnQueryFile);
 
-        const std::vector<PositionStats> stats { collectStatistics(positions, pgnDatabaseFile, threads) };
+        const std::vector<PositionStats> stats { collectStatistics(positions, positionPlyNums, pgnDatabaseFile, threads) };
 
         printStats(positions, stats, positionPlyNums);
 
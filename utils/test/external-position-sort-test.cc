@@ -0,0 +1,157 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "external-position-sort.h"
+
+#include "position-compress-fixed.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+
+namespace hoover_chess_utils::utils::unit_test
+{
+
+namespace
+{
+
+struct TestRecord
+{
+    pgn_reader::CompressedPosition_FixedLength key;
+    std::uint64_t count;
+};
+
+struct TestRecordTraits
+{
+    static const pgn_reader::CompressedPosition_FixedLength &getKey(const TestRecord &record) noexcept
+    {
+        return record.key;
+    }
+
+    static void combine(TestRecord &into, const TestRecord &from) noexcept
+    {
+        into.count += from.count;
+    }
+};
+
+// Random records with numKeys distinct keys, so that the keys repeat. Every
+// key word is random, so that every radix sort digit matters.
+std::vector<TestRecord> generateRecords(std::size_t numRecords, std::size_t numKeys, std::uint64_t seed)
+{
+    std::mt19937_64 rng { seed };
+
+    std::vector<pgn_reader::CompressedPosition_FixedLength> keys(numKeys);
+    for (pgn_reader::CompressedPosition_FixedLength &key : keys)
+    {
+        const std::array<std::uint64_t, 3U> words { rng(), rng(), rng() };
+        std::memcpy(&key, words.data(), sizeof key);
+    }
+
+    std::vector<TestRecord> records { };
+    for (std::size_t i { }; i < numRecords; ++i)
+        records.push_back(TestRecord { keys[rng() % numKeys], rng() % 100U + 1U });
+
+    return records;
+}
+
+// Reference result with std::sort
+std::vector<TestRecord> sortAndCombine(std::vector<TestRecord> records)
+{
+    std::sort(
+        records.begin(), records.end(),
+        [](const TestRecord &lhs, const TestRecord &rhs) noexcept
+        {
+            return lhs.key < rhs.key;
+        });
+
+    std::vector<TestRecord> ret { };
+    for (const TestRecord &record : records)
+    {
+        if (!ret.empty() && ret.back().key == record.key)
+            ret.back().count += record.count;
+        else
+            ret.push_back(record);
+    }
+
+    return ret;
+}
+
+void checkSorter(std::size_t numRecords, std::size_t numKeys, std::size_t memoryBudget, std::size_t numThreads,
+                 std::size_t expectMinSpilledRuns)
+{
+    const std::vector<TestRecord> records { generateRecords(numRecords, numKeys, numRecords + numKeys) };
+    const std::vector<TestRecord> expected { sortAndCombine(records) };
+
+    ExternalPositionSorter<TestRecord, TestRecordTraits> sorter {
+        std::filesystem::temp_directory_path(), memoryBudget, numThreads };
+
+    for (const TestRecord &record : records)
+        sorter.add(record);
+
+    EXPECT_GE(sorter.getNumSpilledRuns(), expectMinSpilledRuns);
+
+    std::vector<TestRecord> sorted { };
+    sorter.finish(
+        [&sorted](const TestRecord &record)
+        {
+            sorted.push_back(record);
+        });
+
+    ASSERT_EQ(expected.size(), sorted.size());
+
+    for (std::size_t i { }; i < expected.size(); ++i)
+    {
+        EXPECT_TRUE(expected[i].key == sorted[i].key) << "i=" << i;
+        EXPECT_EQ(expected[i].count, sorted[i].count) << "i=" << i;
+    }
+}
+
+}
+
+TEST(ExternalPositionSorter, empty)
+{
+    checkSorter(0U, 1U, 0U, 1U, 0U);
+}
+
+TEST(ExternalPositionSorter, inMemory)
+{
+    checkSorter(1000U, 300U, 1U << 20U, 1U, 0U);
+    checkSorter(100000U, 5000U, 64U << 20U, 4U, 0U);
+}
+
+TEST(ExternalPositionSorter, singleMergePass)
+{
+    // The minimum memory budget is 128 KiB, that is, 2048 records of 32
+    // bytes. The merge fan-in is 4 with 256 KiB.
+    checkSorter(12000U, 100000U, 256U << 10U, 2U, 2U);
+}
+
+TEST(ExternalPositionSorter, multipleMergePasses)
+{
+    // With the minimum memory budget, the merge fan-in is 2, so the runs
+    // are merged in several rounds
+    checkSorter(50000U, 20000U, 0U, 2U, 20U);
+    checkSorter(50000U, 100U, 0U, 1U, 20U);
+}
+
+}
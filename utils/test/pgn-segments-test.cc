@@ -0,0 +1,133 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "pgn-segments.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace hoover_chess_utils::utils::unit_test
+{
+
+TEST(PgnSegments, findNextGameStart)
+{
+    constexpr std::string_view pgn {
+        "[Event \"a\"]\n"
+        "[Site \"b\"]\n"
+        "\n"
+        "1. e4 { comment\n"
+        "\n"
+        "[not a tag] } *\n"
+        "\n"
+        "[Event \"c\"]\n"
+        "1. d4 *\n"
+    };
+
+    const std::size_t secondGame { pgn.find("[Event \"c\"]") };
+
+    EXPECT_EQ(findNextGameStart(pgn, 0U), 0U);
+
+    // the comment line is skipped even though it follows an empty line
+    EXPECT_EQ(findNextGameStart(pgn, 1U), secondGame);
+    EXPECT_EQ(findNextGameStart(pgn, secondGame), secondGame);
+    EXPECT_EQ(findNextGameStart(pgn, secondGame + 1U), pgn.size());
+
+    // tag pair syntax
+    EXPECT_EQ(findNextGameStart("[Event\t\"x\"]\n", 0U), 0U);
+    EXPECT_EQ(findNextGameStart("[ Event \"x\"]\n", 0U), 13U);
+    EXPECT_EQ(findNextGameStart("[Event]\n", 0U), 8U);
+    EXPECT_EQ(findNextGameStart("[", 0U), 1U);
+}
+
+TEST(PgnSegments, splitIntoSegments)
+{
+    for (const std::string_view newline : { "\n", "\r\n", "\r" })
+    {
+        std::string pgn { };
+        std::vector<std::size_t> gameStarts { };
+
+        for (std::size_t i { }; i < 100U; ++i)
+        {
+            gameStarts.push_back(pgn.size());
+
+            pgn += "[Event \"x\"]";
+            pgn += newline;
+            pgn += "[Round \"";
+            pgn += std::to_string(i);
+            pgn += "\"]";
+            pgn += newline;
+            pgn += newline;
+            pgn += "1. e4 { multi-line";
+            pgn += newline;
+            pgn += newline;
+            pgn += "[comment] } e5 *";
+            pgn += newline;
+            pgn += newline;
+        }
+
+        for (const std::size_t targetSegmentSize : { std::size_t { 1U }, std::size_t { 100U }, std::size_t { 1000U }, pgn.size() })
+        {
+            std::vector<std::string_view> segments { };
+            segments.emplace_back("previous");
+
+            splitIntoSegments(pgn, targetSegmentSize, segments);
+
+            ASSERT_GE(segments.size(), 2U);
+            EXPECT_EQ(segments.front(), "previous");
+
+            // the segments cover the input, and they start at game starts
+            std::size_t offset { };
+            for (std::size_t i { 1U }; i < segments.size(); ++i)
+            {
+                EXPECT_EQ(segments[i].data(), pgn.data() + offset);
+                EXPECT_NE(std::find(gameStarts.begin(), gameStarts.end(), offset), gameStarts.end());
+                EXPECT_TRUE(i + 1U == segments.size() || segments[i].size() >= targetSegmentSize);
+
+                offset += segments[i].size();
+            }
+
+            EXPECT_EQ(offset, pgn.size());
+
+            if (targetSegmentSize == 1U)
+            {
+                EXPECT_EQ(segments.size(), gameStarts.size() + 1U);
+            }
+        }
+    }
+
+    std::vector<std::string_view> segments { };
+    splitIntoSegments(std::string_view { }, 1U, segments);
+    EXPECT_TRUE(segments.empty());
+}
+
+TEST(PgnSegments, targetSegmentSizeForThreads)
+{
+    // 16 segments per thread
+    EXPECT_EQ(targetSegmentSizeForThreads(std::size_t { 4U } << 30U, 4U), std::size_t { 64U } << 20U);
+    EXPECT_EQ(targetSegmentSizeForThreads(std::size_t { 1U } << 30U, 1U), std::size_t { 64U } << 20U);
+
+    // at least 1 MiB
+    EXPECT_EQ(targetSegmentSizeForThreads(std::size_t { 16U } << 20U, 2U), std::size_t { 1U } << 20U);
+    EXPECT_EQ(targetSegmentSizeForThreads(0U, 1U), std::size_t { 1U } << 20U);
+}
+
+}
@@ -0,0 +1,133 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "position-pattern.h"
+
+#include "chessboard.h"
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string_view>
+
+
+namespace hoover_chess_utils::utils::unit_test
+{
+
+namespace
+{
+
+bool matchesFen(std::string_view pattern, std::string_view fen)
+{
+    pgn_reader::ChessBoard board { };
+    board.loadFEN(fen);
+
+    return PositionPattern::compile(pattern).matches(board);
+}
+
+constexpr std::string_view ctStartFen { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+
+// white king e1, rook a1, pawn e4; black king e8, rook h8
+constexpr std::string_view ctRookEndgameFen { "4k2r/8/8/8/4P3/8/8/R3K3 b - - 0 1" };
+
+}
+
+TEST(PositionPattern, material)
+{
+    EXPECT_TRUE(matchesFen("KRPvKR", ctRookEndgameFen));
+    EXPECT_TRUE(matchesFen("RPvR", ctRookEndgameFen));
+    EXPECT_TRUE(matchesFen("KRPvR", ctRookEndgameFen));
+
+    EXPECT_FALSE(matchesFen("KRvKR", ctRookEndgameFen));
+    EXPECT_FALSE(matchesFen("KRPvKRP", ctRookEndgameFen));
+    EXPECT_FALSE(matchesFen("KRvKRP", ctRookEndgameFen));
+    EXPECT_FALSE(matchesFen("KRPvK", ctRookEndgameFen));
+
+    EXPECT_TRUE(matchesFen("KQRRBBNNPPPPPPPPvKQRRBBNNPPPPPPPP", ctStartFen));
+    EXPECT_FALSE(matchesFen("KQRRBBNNPPPPPPPvKQRRBBNNPPPPPPPP", ctStartFen));
+
+    // the last material term wins
+    EXPECT_TRUE(matchesFen("KvK KRPvKR", ctRookEndgameFen));
+    EXPECT_FALSE(matchesFen("KRPvKR KvK", ctRookEndgameFen));
+}
+
+TEST(PositionPattern, pieceOnSquare)
+{
+    EXPECT_TRUE(matchesFen("Ra1", ctRookEndgameFen));
+    EXPECT_TRUE(matchesFen("Ra1 Pe4 rh8 ke8", ctRookEndgameFen));
+
+    EXPECT_FALSE(matchesFen("Rh8", ctRookEndgameFen));
+    EXPECT_FALSE(matchesFen("ra1", ctRookEndgameFen));
+    EXPECT_FALSE(matchesFen("Ra1 Pe5", ctRookEndgameFen));
+
+    EXPECT_TRUE(matchesFen("Ng1 nb8 Pa2 ph7", ctStartFen));
+}
+
+TEST(PositionPattern, forbidden)
+{
+    EXPECT_TRUE(matchesFen("!Pe5", ctRookEndgameFen));
+    EXPECT_TRUE(matchesFen("!pe4", ctRookEndgameFen));
+    EXPECT_TRUE(matchesFen("Ra1 !Rh1", ctRookEndgameFen));
+
+    EXPECT_FALSE(matchesFen("!Pe4", ctRookEndgameFen));
+    EXPECT_FALSE(matchesFen("Ra1 !rh8", ctRookEndgameFen));
+}
+
+TEST(PositionPattern, sideToMove)
+{
+    EXPECT_TRUE(matchesFen("w", ctStartFen));
+    EXPECT_FALSE(matchesFen("b", ctStartFen));
+
+    EXPECT_TRUE(matchesFen("b", ctRookEndgameFen));
+    EXPECT_FALSE(matchesFen("w", ctRookEndgameFen));
+
+    EXPECT_TRUE(matchesFen("KRPvKR b Ra1", ctRookEndgameFen));
+    EXPECT_FALSE(matchesFen("KRPvKR w Ra1", ctRookEndgameFen));
+}
+
+TEST(PositionPattern, emptyPattern)
+{
+    EXPECT_TRUE(matchesFen("", ctStartFen));
+    EXPECT_TRUE(matchesFen(" \t ", ctRookEndgameFen));
+}
+
+TEST(PositionPattern, syntaxErrors)
+{
+    // material signatures
+    EXPECT_THROW(PositionPattern::compile("KKvK"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("KvKK"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("KRvkr"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("KXvK"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("KvKvK"), std::invalid_argument);
+
+    // piece on square
+    EXPECT_THROW(PositionPattern::compile("Xa1"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("Ri1"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("Ra9"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("Ra"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("Ra1x"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("!"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("!!Ra1"), std::invalid_argument);
+
+    // side to move
+    EXPECT_THROW(PositionPattern::compile("W"), std::invalid_argument);
+    EXPECT_THROW(PositionPattern::compile("wb"), std::invalid_argument);
+
+    EXPECT_NO_THROW(PositionPattern::compile("KvK"));
+    EXPECT_NO_THROW(PositionPattern::compile("v"));
+}
+
+}
@@ -0,0 +1,47 @@
+// Hoover Chess Utilities / TCEC PGN tools
+// Copyright (C) 2025  Sami Kiminki
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOOVER_CHESS_UTILS__UTILS__TO_NUMBER_H_INCLUDED
+#define HOOVER_CHESS_UTILS__UTILS__TO_NUMBER_H_INCLUDED
+
+#include <charconv>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+namespace hoover_chess_utils::utils
+{
+
+// Converts a string to a number. Throws std::runtime_error unless the whole
+// string is a number that fits in NumberType.
+template <typename NumberType>
+NumberType toNumber(std::string_view sv)
+{
+    NumberType ret { };
+    const std::from_chars_result result { std::from_chars(sv.data(), sv.data() + sv.size(), ret) };
+
+    if (result.ec == std::errc { } && result.ptr == sv.data() + sv.size())
+    {
+        return ret;
+    }
+
+    throw std::runtime_error { std::format("Error converting '{}' to number", sv) };
+}
+
+}
+
+#endif